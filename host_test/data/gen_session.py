@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+# Gera uma sessão NMEA sintética (RMC + GGA a 10 Hz) em volta dos checkpoints padrão do
+# lap_timer, para uso nos testes de host. Não é uma gravação real: a trajetória é uma
+# spline fechada pelos checkpoints com ruído gaussiano de ~0,5 m.
+# Com --ubx, grava a mesma sessão em UBX-NAV-PVT binário, com uma sentença RMC a cada
+# 10 épocas no meio, como um receptor u-blox com as duas saídas ligadas:
+#   gen_session.py > session_synthetic.nmea
+#   gen_session.py --ubx > session_synthetic.ubx
+import math
+import random
+import struct
+import sys
+
+LAT0, LON0 = -26.925389, -48.941590     # Linha de chegada
+R = 6371000.0
+RATE_HZ = 10
+LAPS = 3
+
+# Pontos de controle (leste, norte) em metros a partir da linha de chegada
+CONTROL = [(0, 0), (70, 30), (91, 105), (10, 150), (-78, 115), (-70, 40)]
+
+
+def catmull_rom(p0, p1, p2, p3, t):
+    t2, t3 = t * t, t * t * t
+    return tuple(0.5 * ((2 * b) + (-a + c) * t + (2 * a - 5 * b + 4 * c - d) * t2 +
+                        (-a + 3 * b - 3 * c + d) * t3) for a, b, c, d in zip(p0, p1, p2, p3))
+
+
+def dense_path(step=0.05):
+    pts = []
+    n = len(CONTROL)
+    for i in range(n):
+        p0, p1, p2, p3 = (CONTROL[(i + k - 1) % n] for k in range(4))
+        t = 0.0
+        while t < 1.0:
+            pts.append(catmull_rom(p0, p1, p2, p3, t))
+            t += step / 50.0
+    return pts
+
+
+def nmea(body):
+    cs = 0
+    for ch in body:
+        cs ^= ord(ch)
+    return '$%s*%02X' % (body, cs)
+
+
+def ubx(msg_class, msg_id, payload):
+    body = struct.pack('<BBH', msg_class, msg_id, len(payload)) + payload
+    ck_a = ck_b = 0
+    for byte in body:
+        ck_a = (ck_a + byte) & 0xFF
+        ck_b = (ck_b + ck_a) & 0xFF
+    return b'\xb5\x62' + body + bytes((ck_a, ck_b))
+
+
+def nav_pvt(t, lat, lon, speed_kmh, heading):
+    hh, rem = divmod(int(round(t * 1000)), 3600000)
+    mm, rem = divmod(rem, 60000)
+    ss, ms = divmod(rem, 1000)
+    itow = (4 * 86400 + 18) * 1000 + int(round(t * 1000))   # 15/10/2026 é quinta-feira
+    payload = struct.pack('<IHBBBBBBIiBBBBiiiiIIiiiiiIIHB5xihH',
+                          itow, 2026, 10, 15, hh, mm, ss, 0x07, 50, ms * 1000000,
+                          3, 0x01, 0, 12,
+                          round(lon * 1e7), round(lat * 1e7), 12300 + 1200, 12300, 1500, 2500,
+                          0, 0, 0, round(speed_kmh / 3.6 * 1000), round(heading * 1e5),
+                          300, 50000, 150, 0, 0, 0, 0)
+    return ubx(0x01, 0x07, payload)
+
+
+def ddmm(value, deg_digits):
+    v = abs(value)
+    deg = int(v)
+    minutes = (v - deg) * 60.0
+    return '%0*d%08.5f' % (deg_digits, deg, minutes)
+
+
+def main():
+    random.seed(42)
+    path = dense_path()
+    seg = [math.dist(path[i], path[(i + 1) % len(path)]) for i in range(len(path))]
+    lap_len = sum(seg)
+
+    binary = '--ubx' in sys.argv[1:]
+    out = sys.stdout.buffer if binary else sys.stdout
+    epoch = 0
+    t = 12 * 3600 + 30 * 60      # 12:30:00 UTC
+    s = lap_len - 30.0           # Começa 30 m antes da linha
+    idx, acc = 0, 0.0
+    total = LAPS * lap_len + 30.0 + 20.0
+    travelled = 0.0
+    while travelled < total:
+        pos_along = s % lap_len
+        # Localiza o ponto na trajetória densa
+        while acc + seg[idx] < pos_along or acc > pos_along:
+            acc += seg[idx]
+            idx += 1
+            if idx == len(path):
+                idx, acc = 0, 0.0
+        frac = (pos_along - acc) / seg[idx] if seg[idx] else 0.0
+        a, b = path[idx], path[(idx + 1) % len(path)]
+        east = a[0] + (b[0] - a[0]) * frac + random.gauss(0, 0.5)
+        north = a[1] + (b[1] - a[1]) * frac + random.gauss(0, 0.5)
+        heading = math.degrees(math.atan2(b[0] - a[0], b[1] - a[1])) % 360.0
+
+        speed_kmh = 55.0 + 15.0 * math.sin(2 * math.pi * pos_along / lap_len * 2)
+        lat = LAT0 + math.degrees(north / R)
+        lon = LON0 + math.degrees(east / (R * math.cos(math.radians(LAT0))))
+
+        hh, rem = divmod(t, 3600)
+        mm, ss = divmod(rem, 60)
+        utc = '%02d%02d%05.2f' % (hh, mm, ss)
+        lat_s, ns = ddmm(lat, 2), 'S' if lat < 0 else 'N'
+        lon_s, ew = ddmm(lon, 3), 'W' if lon < 0 else 'E'
+        rmc = nmea('GNRMC,%s,A,%s,%s,%s,%s,%.2f,%.1f,151026,,,A' %
+                   (utc, lat_s, ns, lon_s, ew, speed_kmh / 1.852, heading)) + '\r\n'
+        if binary:
+            out.write(nav_pvt(t, lat, lon, speed_kmh, heading))
+            if epoch % 10 == 0:
+                out.write(rmc.encode())
+        else:
+            out.write(rmc)
+            out.write(nmea('GNGGA,%s,%s,%s,%s,%s,1,12,0.8,12.3,M,1.2,M,,' %
+                           (utc, lat_s, ns, lon_s, ew)) + '\r\n')
+        epoch += 1
+
+        step = speed_kmh / 3.6 / RATE_HZ
+        s += step
+        travelled += step
+        t = round(t + 1.0 / RATE_HZ, 2)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,169 @@
+// Relatório de precisão e custo do motor de voltas, fix a fix sobre uma sessão gravada:
+// - o plano tangente local contra a distância de grande círculo (haversine): distância de cada fix
+//   até a chegada e, em cada cruzamento, a posição interpolada até o centro da linha;
+// - a versão em float (a do menuconfig) contra a mesma geometria em double (lap_engine_ref.c):
+//   instantes de cruzamento das linhas e custo por fix do caminho projeção + teste da linha.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lap_engine.h"
+#include "lap_engine_ref.h"
+#include "nmea.h"
+
+#define MAX_FIXES 100000
+#define MAX_CROSSINGS 1000
+#define TOLERANCE_US 100    // Diferença máxima aceita no instante de cruzamento
+#define TOLERANCE_M 0.1     // Diferença máxima aceita entre a distância no plano e a haversine
+
+static int32_t fix_lat[MAX_FIXES], fix_lon[MAX_FIXES];
+static int64_t fix_us[MAX_FIXES];
+
+typedef struct {
+    int count;
+    int64_t us[MAX_CROSSINGS];
+    int fix[MAX_CROSSINGS];         // Fix que fechou o trajeto do cruzamento
+    uint8_t gate[MAX_CROSSINGS];    // Linha cruzada
+} Crossings;
+
+// Maior diferença entre a distância no plano e a haversine
+typedef struct {
+    int count;
+    double max_err;
+    double max_dist;                // Maior distância haversine comparada
+} DistanceError;
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Cada passagem por uma linha atualiza last_checkpoint_time com o instante interpolado. A linha
+// cruzada é a esperada antes do fix (next_gate avançou uma) ou a chegada (volta inválida).
+static void record(Crossings *c, const LapState *state, int64_t *last, int fix, uint8_t expected,
+                   uint8_t gate_count){
+    if (state->started && state->last_checkpoint_time != *last && c->count < MAX_CROSSINGS) {
+        *last = state->last_checkpoint_time;
+        c->us[c->count] = *last;
+        c->fix[c->count] = fix;
+        c->gate[c->count] = state->next_gate == (expected + 1) % gate_count ? expected : 0;
+        c->count++;
+    }
+}
+
+// Distância de um ponto até outro, no plano da referência, com a mesma aritmética do motor
+// (diferença inteira em 1e-7 grau vezes a escala), contra a haversine em double
+static void distance_compare(DistanceError *d, const PlanarRef *ref, double lat, double lon,
+                             double to_lat, double to_lon){
+    lap_real_t north = (lap_real_t)((int32_t)lround(lat * 1e7) - (int32_t)lround(to_lat * 1e7)) * ref->north_m;
+    lap_real_t east = (lap_real_t)((int32_t)lround(lon * 1e7) - (int32_t)lround(to_lon * 1e7)) * ref->east_m;
+    double planar = sqrt((double)east * east + (double)north * north);
+    double great_circle = haversine(lat, lon, to_lat, to_lon);
+    double err = fabs(planar - great_circle);
+
+    d->count++;
+    d->max_err = err > d->max_err ? err : d->max_err;
+    d->max_dist = great_circle > d->max_dist ? great_circle : d->max_dist;
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        fprintf(stderr, "uso: %s sessao.nmea\n", argv[0]);
+        return 2;
+    }
+    FILE *f = fopen(argv[1], "r");
+    if (!f) {
+        perror(argv[1]);
+        return 2;
+    }
+
+    char line[256];
+    int count = 0;
+    while (fgets(line, sizeof(line), f) && count < MAX_FIXES) {
+        GnssFix rmc;
+        if (nmea_parse_rmc(line, strcspn(line, "\r\n"), &rmc) && rmc.valid) {
+            fix_lat[count] = rmc.lat_e7;
+            fix_lon[count] = rmc.lon_e7;
+            fix_us[count] = (int64_t)rmc.utc_ms * 1000;
+            count++;
+        }
+    }
+    fclose(f);
+
+    // Os dois motores recebem os mesmos fixes; cada cruzamento é comparado com o do outro
+    static Crossings single, dual;
+    int64_t last_single = -1, last_dual = -1;
+    const TrackDef *track = lap_engine_track();
+    lap_engine_load_track(track);
+    ref_lap_engine_load_track(track);
+    for (int i = 0; i < count; i++) {
+        uint8_t expected = lap_state.next_gate, ref_expected = ref_lap_state.next_gate;
+        process_position(fix_lat[i], fix_lon[i], fix_us[i]);
+        ref_process_position(fix_lat[i], fix_lon[i], fix_us[i]);
+        record(&single, &lap_state, &last_single, i, expected, track->gate_count);
+        record(&dual, &ref_lap_state, &last_dual, i, ref_expected, track->gate_count);
+    }
+
+    // Plano da pista (origem na chegada, escalas do motor) contra a haversine: cada fix até a
+    // chegada e, em cada cruzamento, o ponto interpolado no instante até o centro da linha
+    const TrackGate *finish = &track->gates[0];
+    PlanarRef ref = planar_ref_init(finish->lat, finish->lon);
+    DistanceError fix_dist = { 0 }, cross_dist = { 0 };
+    for (int i = 0; i < count; i++) {
+        distance_compare(&fix_dist, &ref, fix_lat[i] * 1e-7, fix_lon[i] * 1e-7, finish->lat, finish->lon);
+    }
+    for (int i = 0; i < single.count; i++) {
+        int k = single.fix[i];
+        if (k == 0) {
+            continue;
+        }
+        double f = (double)(single.us[i] - fix_us[k - 1]) / (double)(fix_us[k] - fix_us[k - 1]);
+        double lat = (fix_lat[k - 1] + f * (fix_lat[k] - fix_lat[k - 1])) * 1e-7;
+        double lon = (fix_lon[k - 1] + f * (fix_lon[k] - fix_lon[k - 1])) * 1e-7;
+        const TrackGate *gate = &track->gates[single.gate[i]];
+        distance_compare(&cross_dist, &ref, lat, lon, gate->lat, gate->lon);
+    }
+
+    int64_t max_err = 0;
+    double sum_sq = 0.0;
+    int compared = single.count < dual.count ? single.count : dual.count;
+    for (int i = 0; i < compared; i++) {
+        int64_t err = llabs(single.us[i] - dual.us[i]);
+        max_err = err > max_err ? err : max_err;
+        sum_sq += (double)err * err;
+    }
+
+    // Custo por fix no host (os ciclos na ESP32 saem com CONFIG_LAP_TIMER_ENGINE_BENCHMARK)
+    const int rounds = 200;
+    double t0 = now_s();
+    for (int r = 0; r < rounds; r++) {
+        lap_engine_load_track(track);
+        for (int i = 0; i < count; i++) {
+            process_position(fix_lat[i], fix_lon[i], fix_us[i]);
+        }
+    }
+    double t_single = now_s() - t0;
+    t0 = now_s();
+    for (int r = 0; r < rounds; r++) {
+        ref_lap_engine_load_track(track);
+        for (int i = 0; i < count; i++) {
+            ref_process_position(fix_lat[i], fix_lon[i], fix_us[i]);
+        }
+    }
+    double t_dual = now_s() - t0;
+
+    printf("fixes: %d, cruzamentos: float %d, double %d\n", count, single.count, dual.count);
+    printf("plano x haversine, fix ate a chegada: erro maximo %.4f m (ate %.0f m)\n", fix_dist.max_err,
+           fix_dist.max_dist);
+    printf("plano x haversine, cruzamento ate o centro da linha: erro maximo %.4f m (ate %.1f m, %d cruzamentos)\n",
+           cross_dist.max_err, cross_dist.max_dist, cross_dist.count);
+    printf("instante de cruzamento: erro maximo %lld us, RMS %.1f us\n", (long long)max_err,
+           compared ? sqrt(sum_sq / compared) : 0.0);
+    printf("motor float:  %6.1f ns/fix\n", t_single * 1e9 / ((double)rounds * count));
+    printf("motor double: %6.1f ns/fix\n", t_dual * 1e9 / ((double)rounds * count));
+
+    return (count > 0 && single.count > 0 && single.count == dual.count && max_err <= TOLERANCE_US &&
+            fix_dist.max_err <= TOLERANCE_M && cross_dist.max_err <= TOLERANCE_M) ? 0 : 1;
+}
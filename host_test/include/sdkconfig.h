@@ -0,0 +1,5 @@
+// Configuração usada no build de host, no lugar do sdkconfig.h gerado pelo ESP-IDF
+#pragma once
+
+#define CONFIG_LAP_TIMER_ENGINE_PLANAR 1
+#define CONFIG_LAP_TIMER_GNSS_NMEA 1
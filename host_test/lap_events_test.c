@@ -0,0 +1,122 @@
+// Teste de host do anel de eventos de volta: um escritor publicando sem parar e leitores em
+// threads, um rápido e um lento. Confere que cada leitor vê os eventos em ordem, nunca um
+// evento pela metade, e que lidos + perdidos fecha com o total publicado.
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+#include "lap_events.h"
+
+#define EVENTS 200000
+#define BURST 32                    // Eventos publicados de uma vez antes de uma pausa do escritor
+#define SLOW_EVERY 100              // O leitor lento dorme a cada tantos eventos lidos
+
+typedef struct {
+    LapEventReader reader;
+    bool slow;
+    uint32_t received;
+    uint32_t errors;
+} Consumer;
+
+static atomic_bool writer_done;
+
+// O conteúdo do evento é derivado do seq, para detectar cópias misturadas de dois eventos
+static void fill(LapEvent *event, uint32_t n){
+    event->type = LAP_EVENT_SECTOR;
+    event->sector = (uint8_t)n;
+    event->lap = (uint16_t)(n >> 8);
+    event->time_us = (int64_t)n * 1000;
+    event->duration_us = -(int64_t)n;
+}
+
+static bool consistent(const LapEvent *event){
+    uint32_t n = event->seq;
+    return event->sector == (uint8_t)n && event->lap == (uint16_t)(n >> 8) &&
+           event->time_us == (int64_t)n * 1000 && event->duration_us == -(int64_t)n;
+}
+
+static void *consume(void *arg){
+    Consumer *c = (Consumer *)arg;
+    LapEvent event;
+    uint32_t last = 0;
+
+    for (;;) {
+        bool done = atomic_load(&writer_done);
+        while (lap_events_read(&c->reader, &event)) {
+            if (event.seq <= last || !consistent(&event)) {
+                c->errors++;
+            }
+            last = event.seq;
+            if (++c->received % SLOW_EVERY == 0 && c->slow) {
+                nanosleep(&(struct timespec){ .tv_nsec = 1000000 }, NULL);
+            }
+        }
+        if (done) {
+            return NULL;
+        }
+    }
+}
+
+int main(void){
+    int failures = 0;
+    LapEventReader reader;
+    LapEvent event;
+
+    // Leitor em dia: todos os eventos, na ordem
+    lap_events_reader_init(&reader);
+    for (uint32_t i = 1; i <= 10; i++) {
+        fill(&event, i);
+        lap_events_publish(&event);
+    }
+    uint32_t count = 0;
+    while (lap_events_read(&reader, &event)) {
+        failures += event.seq != reader.next - 1 || !consistent(&event);
+        count++;
+    }
+    printf("em dia: %u lidos, %u perdidos\n", count, reader.dropped);
+    failures += count != 10 || reader.dropped != 0;
+
+    // Leitor atrasado mais que o anel: fica com os mais recentes e conta o resto
+    for (uint32_t i = 0; i < 200; i++) {
+        fill(&event, lap_events_head() + 1);
+        lap_events_publish(&event);
+    }
+    count = 0;
+    while (lap_events_read(&reader, &event)) {
+        count++;
+    }
+    printf("atrasado: %u lidos, %u perdidos\n", count, reader.dropped);
+    failures += count != LAP_EVENT_RING_SIZE || reader.dropped != 200 - LAP_EVENT_RING_SIZE;
+
+    // Concorrente: o escritor nunca espera pelos leitores
+    Consumer fast = { .slow = false }, slow = { .slow = true };
+    lap_events_reader_init(&fast.reader);
+    lap_events_reader_init(&slow.reader);
+    pthread_t threads[2];
+    pthread_create(&threads[0], NULL, consume, &fast);
+    pthread_create(&threads[1], NULL, consume, &slow);
+
+    // Rajadas de metade do anel: o leitor rápido acompanha, o lento fica para trás
+    uint32_t first = lap_events_head() + 1;
+    for (uint32_t i = 0; i < EVENTS; i++) {
+        fill(&event, first + i);
+        lap_events_publish(&event);
+        if (i % BURST == BURST - 1) {
+            nanosleep(&(struct timespec){ .tv_nsec = 10000 }, NULL);
+        }
+    }
+    atomic_store(&writer_done, true);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+
+    Consumer *consumers[] = { &fast, &slow };
+    for (int i = 0; i < 2; i++) {
+        Consumer *c = consumers[i];
+        printf("leitor %s: %u lidos, %u perdidos, %u erros\n", c->slow ? "lento" : "rapido",
+               c->received, c->reader.dropped, c->errors);
+        failures += c->errors != 0 || c->received + c->reader.dropped != EVENTS;
+    }
+    failures += slow.reader.dropped == 0; // O lento precisa ter ficado para trás
+
+    return failures ? 1 : 0;
+}
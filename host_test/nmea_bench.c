@@ -0,0 +1,212 @@
+// Benchmark de host: compara o parser NMEA original (cópia dos campos em tokens[20][20])
+// com o tokenizador sem cópia de nmea.c, em sentenças por segundo. Antes confere que as
+// coordenadas malformadas (que passariam pelo checksum) deixam o fix inválido.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "nmea.h"
+
+static const char *sentences[] = {
+    "$GNRMC,123519.00,A,2655.52334,S,04856.49540,W,22.4,084.4,230394,003.1,W,A*0E",
+    "$GNRMC,123519.10,A,2655.46652,S,04856.44044,W,35.1,084.4,230394,003.1,W,A*00",
+    "$GNRMC,123519.20,A,2655.46130,S,04856.54262,W,41.9,084.4,230394,003.1,W,A*0C",
+    "$GNRMC,123519.30,V,,,,,,,230394,,,N*62",
+};
+#define SENTENCE_COUNT (sizeof(sentences) / sizeof(sentences[0]))
+
+// Sentenças com uma coordenada corrompida: nenhuma pode gerar posição
+static const char *malformed[] = {
+    "$GNRMC,123519.00,A,26x5.52334,S,04856.49540,W,22.4,084.4,230394,003.1,W,A*0E",
+    "$GNRMC,123519.00,A,2655.5x334,S,04856.49540,W,22.4,084.4,230394,003.1,W,A*0E",
+    "$GNRMC,123519.00,A,2655.52334,S,04856.49540,X,22.4,084.4,230394,003.1,W,A*0E",
+    "$GNRMC,123519.00,A,2675.52334,S,04856.49540,W,22.4,084.4,230394,003.1,W,A*0E",
+    "$GNRMC,123519.00,A,9155.52334,S,04856.49540,W,22.4,084.4,230394,003.1,W,A*0E",
+    "$GNRMC,123519.00,A,2655.52334,S,48.49540,W,22.4,084.4,230394,003.1,W,A*0E",
+    "$GNRMC,123519.00,A,2655.52334,,04856.49540,W,22.4,084.4,230394,003.1,W,A*0E",
+};
+#define MALFORMED_COUNT (sizeof(malformed) / sizeof(malformed[0]))
+
+static int epoch_fixes, epoch_valid;
+
+static void on_epoch(const GnssFix *fix, void *ctx){
+    (void)ctx;
+    epoch_fixes++;
+    epoch_valid += fix->valid;
+}
+
+static double sink_lat, sink_lon, sink_speed;
+
+// ---- Implementação original de lap_timer.c, mantida como referência ----
+
+static double legacy_nmea_to_decimal(const char *coord, char direction){
+    double degrees = 0.0;
+    double minutes = 0.0;
+
+    if (strlen(coord) > 7) {
+        if (coord[4] == '.') {
+            sscanf(coord, "%2lf%lf", &degrees, &minutes);
+        } else {
+            sscanf(coord, "%3lf%lf", &degrees, &minutes);
+        }
+    }
+
+    double decimal = degrees + (minutes / 60.0);
+    if (direction == 'S' || direction == 'W') {
+        decimal = -decimal;
+    }
+    return decimal;
+}
+
+static void legacy_process_nmea_line(const char *line){
+    if (strncmp(line, "$GNRMC", 6) == 0) {
+        char tokens[20][20];
+        int token_count = 0;
+        const char *ptr = line;
+
+        while (*ptr) {
+            char *comma = strchr(ptr, ',');
+            if (comma == NULL) {
+                strcpy(tokens[token_count++], ptr);
+                break;
+            } else {
+                strncpy(tokens[token_count], ptr, comma - ptr);
+                tokens[token_count][comma - ptr] = '\0';
+                token_count++;
+                ptr = comma + 1;
+            }
+        }
+
+        if (strcmp(tokens[2], "A") == 0) {
+            double latitude = legacy_nmea_to_decimal(tokens[3], tokens[4][0]);
+            double longitude = legacy_nmea_to_decimal(tokens[5], tokens[6][0]);
+            double speed_knots = atof(tokens[7]);
+            sink_speed = speed_knots * 1.852;
+
+            char utc_time[16];
+            strncpy(utc_time, tokens[1], sizeof(utc_time));
+            int hours, minutes, seconds;
+            sscanf(utc_time, "%2d%2d%2d", &hours, &minutes, &seconds);
+
+            char date[16];
+            strncpy(date, tokens[9], sizeof(date));
+            int day, month, year;
+            sscanf(date, "%2d%2d%2d", &day, &month, &year);
+
+            sink_lat = latitude;
+            sink_lon = longitude;
+        }
+    }
+}
+
+// ---- Implementação nova ----
+
+static void new_process_nmea_line(const char *line, size_t len){
+    GnssFix rmc;
+    if (nmea_parse_rmc(line, len, &rmc) && rmc.valid) {
+        sink_speed = rmc.speed_kmh;
+        sink_lat = rmc.lat_e7 * 1e-7;
+        sink_lon = rmc.lon_e7 * 1e-7;
+    }
+}
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv){
+    long iterations = argc > 1 ? atol(argv[1]) : 1000000;
+    size_t lengths[SENTENCE_COUNT];
+
+    for (size_t i = 0; i < SENTENCE_COUNT; i++) {
+        lengths[i] = strlen(sentences[i]);
+    }
+
+    // Confere que as duas implementações produzem as mesmas coordenadas (resolução de 1e-7 grau)
+    for (size_t i = 0; i < SENTENCE_COUNT; i++) {
+        legacy_process_nmea_line(sentences[i]);
+        double lat = sink_lat, lon = sink_lon;
+        new_process_nmea_line(sentences[i], lengths[i]);
+        if (fabs(lat - sink_lat) > 1e-7 || fabs(lon - sink_lon) > 1e-7) {
+            fprintf(stderr, "Divergência na sentença %zu: %.9f,%.9f vs %.9f,%.9f\n",
+                    i, lat, lon, sink_lat, sink_lon);
+            return 1;
+        }
+    }
+
+    // Coordenada malformada: RMC isolado inválido, e a época com um GGA correto também
+    for (size_t i = 0; i < MALFORMED_COUNT; i++) {
+        GnssFix rmc;
+        if (!nmea_parse_rmc(malformed[i], strlen(malformed[i]), &rmc) || rmc.valid ||
+            (rmc.fields & GNSS_HAS_POSITION) || rmc.lat_e7 || rmc.lon_e7) {
+            fprintf(stderr, "Coordenada malformada aceita: %s\n", malformed[i]);
+            return 1;
+        }
+    }
+    static const char *gga = "$GNGGA,123519.00,2655.52334,S,04856.49540,W,1,08,0.9,545.4,M,46.9,M,,*47";
+    NmeaEpoch epoch;
+    nmea_epoch_init(&epoch, on_epoch, NULL);
+    nmea_epoch_feed(&epoch, malformed[0], strlen(malformed[0]), 0);
+    nmea_epoch_feed(&epoch, gga, strlen(gga), 0);
+    nmea_epoch_feed(&epoch, sentences[1], strlen(sentences[1]), 0);    // Novo horário fecha a época
+    if (epoch_fixes != 1 || epoch_valid != 0) {
+        fprintf(stderr, "Época com coordenada malformada: %d fixes, %d válidos\n", epoch_fixes, epoch_valid);
+        return 1;
+    }
+    int32_t e7;
+    NmeaField good = { "2655.52334", 10 };
+    if (!nmea_to_e7(&good, 'S', &e7) || e7 != -269253890) {
+        fprintf(stderr, "Coordenada correta recusada: %ld\n", (long)e7);
+        return 1;
+    }
+
+    double t0 = now_s();
+    for (long n = 0; n < iterations; n++) {
+        legacy_process_nmea_line(sentences[n % SENTENCE_COUNT]);
+    }
+    double t_legacy = now_s() - t0;
+
+    t0 = now_s();
+    for (long n = 0; n < iterations; n++) {
+        size_t i = n % SENTENCE_COUNT;
+        new_process_nmea_line(sentences[i], lengths[i]);
+    }
+    double t_new = now_s() - t0;
+
+    printf("original:   %12.0f sentencas/s\n", iterations / t_legacy);
+    printf("sem copia:  %12.0f sentencas/s\n", iterations / t_new);
+    printf("ganho:      %12.2fx\n", t_legacy / t_new);
+
+    // Decodificação isolada de coordenadas: sscanf + double vs. inteiro em 1e-7 grau
+    static const char *coords[] = { "2655.52334", "04856.49540", "2655.4613012", "04856.5426" };
+    volatile double sink_d = 0.0;
+    volatile int32_t sink_i = 0;
+
+    t0 = now_s();
+    for (long n = 0; n < iterations; n++) {
+        sink_d = legacy_nmea_to_decimal(coords[n & 3], 'S');
+    }
+    double t_coord_legacy = now_s() - t0;
+
+    NmeaField fields[4];
+    for (int i = 0; i < 4; i++) {
+        fields[i].ptr = coords[i];
+        fields[i].len = strlen(coords[i]);
+    }
+    int32_t coord_e7 = 0;
+    t0 = now_s();
+    for (long n = 0; n < iterations; n++) {
+        nmea_to_e7(&fields[n & 3], 'S', &coord_e7);
+        sink_i = coord_e7;
+    }
+    double t_coord_new = now_s() - t0;
+    (void)sink_d;
+    (void)sink_i;
+
+    printf("coordenada sscanf: %8.1f ns\n", t_coord_legacy * 1e9 / iterations);
+    printf("coordenada e7:     %8.1f ns\n", t_coord_new * 1e9 / iterations);
+    return 0;
+}
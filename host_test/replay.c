@@ -0,0 +1,177 @@
+// Replay de sessões gravadas pelo mesmo caminho do firmware: bytes da UART -> montador de
+// linhas (ou leitor UBX) -> épocas -> motor de voltas. Mostra as voltas e setores da sessão e
+// mede a vazão repetindo a sessão inteira, como referência de regressão e desempenho.
+//   replay [--ubx] [--laps N] [--repeat N] sessao
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "line_assembler.h"
+#include "gnss_pipeline.h"
+#include "lap_engine.h"
+#include "lap_events.h"
+
+#define UART_CHUNK 120              // Bytes por leitura, como o FIFO da UART da ESP32
+#define BYTE_TIME_US 87             // Um byte a 115200 baud
+
+typedef struct {
+    bool print;                 // Mostra os eventos (só na primeira passada)
+    LapEventReader reader;      // Leitor do anel de eventos do motor
+    int laps;
+    int sectors_total;
+    int invalid;
+} Events;
+
+// Consome os eventos publicados pelo motor, como o log do firmware
+static void on_fix(const GnssFix *fix, int64_t epoch_us, void *ctx){
+    Events *ev = (Events *)ctx;
+    LapEvent event;
+    char text[20];
+    (void)fix;
+    (void)epoch_us;
+
+    while (lap_events_read(&ev->reader, &event)) {
+        switch (event.type) {
+        case LAP_EVENT_SECTOR:
+            ev->sectors_total++;
+            break;
+        case LAP_EVENT_LAP_COMPLETE:
+            ev->laps++;
+            break;
+        case LAP_EVENT_LAP_INVALID:
+            ev->invalid++;
+            break;
+        default:
+            continue;
+        }
+        if (ev->print) {
+            lap_format_time(text, sizeof(text), event.duration_us);
+            if (event.type == LAP_EVENT_SECTOR) {
+                printf("  setor %u: %s\n", (unsigned)event.sector, text);
+            } else {
+                printf("volta %u%s: %s\n", (unsigned)event.lap,
+                       event.type == LAP_EVENT_LAP_INVALID ? " (invalida)" : "", text);
+            }
+        }
+    }
+}
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Uma passada pela sessão; retorna a quantidade de sentenças (ou quadros UBX) e de fixes
+static long replay_once(const uint8_t *data, size_t size, bool ubx, LineAssembler *la, Events *ev,
+                        uint32_t *fixes){
+    GnssPipeline pipeline;
+    long lines = 0;
+    int64_t arrival_us = 0;
+
+    gnss_pipeline_init(&pipeline, true, on_fix, ev);
+    lap_engine_load_track(lap_engine_track());
+    lap_last = (LapResult){ 0 };
+    lap_events_reader_init(&ev->reader);
+    line_asm_init(la);
+
+    for (size_t pos = 0; pos < size;) {
+        size_t chunk = size - pos < UART_CHUNK ? size - pos : UART_CHUNK;
+        arrival_us += (int64_t)chunk * BYTE_TIME_US;
+
+        if (ubx) {
+            gnss_pipeline_ubx(&pipeline, data + pos, chunk, arrival_us);
+            pos += chunk;
+            continue;
+        }
+
+        size_t space;
+        char *dst = line_asm_reserve(la, &space);
+        if (chunk > space) {
+            chunk = space;
+        }
+        memcpy(dst, data + pos, chunk);
+        line_asm_commit(la, chunk);
+        pos += chunk;
+
+        const char *line;
+        size_t len;
+        while (line_asm_next(la, &line, &len)) {
+            gnss_pipeline_nmea_line(&pipeline, line, len, arrival_us);
+            lines++;
+        }
+    }
+    *fixes = pipeline.fixes;
+    return ubx ? (long)pipeline.ubx.frames : lines;
+}
+
+int main(int argc, char **argv){
+    bool ubx = false;
+    int expect_laps = -1;
+    long repeat = 100;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ubx") == 0) {
+            ubx = true;
+        } else if (strcmp(argv[i], "--laps") == 0 && i + 1 < argc) {
+            expect_laps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atol(argv[++i]);
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path || repeat < 1) {
+        fprintf(stderr, "uso: %s [--ubx] [--laps N] [--repeat N] sessao\n", argv[0]);
+        return 2;
+    }
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        perror(path);
+        return 2;
+    }
+    fseek(fp, 0, SEEK_END);
+    size_t size = (size_t)ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *data = malloc(size);
+    LineAssembler *la = malloc(sizeof(LineAssembler));
+    if (!data || !la || fread(data, 1, size, fp) != size) {
+        fprintf(stderr, "falha ao ler %s\n", path);
+        fclose(fp);
+        return 2;
+    }
+    fclose(fp);
+
+    // Eventos da sessão
+    Events ev = { .print = true };
+    uint32_t fixes;
+    long messages = replay_once(data, size, ubx, la, &ev, &fixes);
+    printf("%d voltas, %d invalidas, %d setores, %ld %s, %lu fixes, %lu eventos perdidos\n", ev.laps,
+           ev.invalid, ev.sectors_total, messages, ubx ? "quadros" : "sentencas", (unsigned long)fixes,
+           (unsigned long)ev.reader.dropped);
+
+    // Vazão: a sessão inteira repetida, com o motor reiniciado a cada passada
+    double t0 = now_s();
+    for (long r = 0; r < repeat; r++) {
+        Events quiet = { .print = false };
+        uint32_t unused;
+        replay_once(data, size, ubx, la, &quiet, &unused);
+    }
+    double elapsed = now_s() - t0;
+
+    double total_messages = (double)messages * repeat;
+    printf("%s: %12.0f/s (%.1f ns cada)\n", ubx ? "quadros" : "sentencas",
+           total_messages / elapsed, elapsed * 1e9 / total_messages);
+    printf("fixes:     %12.1f ns/fix\n", elapsed * 1e9 / ((double)fixes * repeat));
+    printf("bytes:     %12.1f MB/s\n", (double)size * repeat / elapsed / 1e6);
+
+    free(data);
+    free(la);
+    if (ev.reader.dropped || (expect_laps >= 0 && ev.laps != expect_laps)) {
+        fprintf(stderr, "esperava %d voltas, medi %d\n", expect_laps, ev.laps);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Teste de host da base de tempo: simula um esp_timer com desvio de frequência, fixes a 10 Hz
+// chegando com atraso e jitter, e bordas de PPS com a latência da ISR. Confere o erro do
+// instante local estimado para cada época, com e sem PPS, passando pela meia-noite, com um
+// pulso espúrio e um intervalo sem PPS. Confere também o horário GNSS contínuo na meia-noite.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "timebase.h"
+
+#define MS_PER_DAY 86400000
+#define DRIFT_PPM 35.0              // esp_timer adiantado em relação ao GNSS
+#define START_UTC_MS (MS_PER_DAY - 30000)   // 23:59:30, para passar pela meia-noite
+#define DURATION_MS 120000
+#define FIX_PERIOD_MS 100
+#define BASE_DELAY_US 40000         // Atraso fixo do receptor e da UART
+#define JITTER_US 30000             // Jitter de fila e de escalonamento
+#define DROPOUT_FROM_MS 60000       // Intervalo sem PPS
+#define DROPOUT_TO_MS 75000
+
+static int64_t true_local_us(int64_t gnss_us){
+    return 5000000 + gnss_us + (int64_t)llround(gnss_us * DRIFT_PPM * 1e-6);
+}
+
+static double uniform(double lo, double hi){
+    return lo + (hi - lo) * rand() / (double)RAND_MAX;
+}
+
+typedef struct {
+    double max_abs;         // Maior erro absoluto
+    double min, max;        // Faixa do erro (a largura é o jitter que sobrou)
+    int samples;
+} Stats;
+
+static void stats_add(Stats *s, double err){
+    if (s->samples++ == 0) {
+        s->min = s->max = err;
+    }
+    s->min = err < s->min ? err : s->min;
+    s->max = err > s->max ? err : s->max;
+    s->max_abs = fabs(err) > s->max_abs ? fabs(err) : s->max_abs;
+}
+
+static void run(bool with_pps, Stats *locked, Stats *dropout, Timebase *tb){
+    timebase_init(tb);
+    srand(with_pps ? 7 : 11);
+
+    for (int64_t t_ms = 0; t_ms <= DURATION_MS; t_ms += FIX_PERIOD_MS) {
+        uint32_t utc_ms = (uint32_t)((START_UTC_MS + t_ms) % MS_PER_DAY);
+        int64_t true_us = true_local_us(t_ms * 1000);
+
+        bool in_dropout = t_ms >= DROPOUT_FROM_MS && t_ms < DROPOUT_TO_MS;
+        if (with_pps && t_ms % 1000 == 0 && !in_dropout) {
+            timebase_pps_edge(tb, true_us + (int64_t)uniform(1, 4)); // Latência da ISR
+        }
+        if (with_pps && t_ms == 20300) {
+            timebase_pps_edge(tb, true_us + 150); // Pulso espúrio no meio do segundo
+        }
+
+        // Fix chega com atraso fixo, jitter e, de vez em quando, um pico de escalonamento
+        int64_t arrival_us = true_us + BASE_DELAY_US + (int64_t)uniform(0, JITTER_US);
+        if (rand() % 50 == 0) {
+            arrival_us += 100000;
+        }
+        timebase_fix(tb, utc_ms, arrival_us);
+
+        if (t_ms < 10000) {
+            continue; // Convergência inicial
+        }
+        double err = (double)(timebase_to_local(tb, utc_ms) - true_us);
+        if (with_pps && (in_dropout || (t_ms >= DROPOUT_TO_MS && t_ms < DROPOUT_TO_MS + 10000))) {
+            stats_add(dropout, err);
+        } else {
+            stats_add(locked, err);
+        }
+    }
+}
+
+int main(void){
+    Timebase tb;
+    Stats pps = { 0 }, pps_dropout = { 0 }, envelope = { 0 }, unused = { 0 };
+    int failures = 0;
+
+    run(true, &pps, &pps_dropout, &tb);
+    printf("com PPS: erro max %.1f us, pulsos %lu, associados %lu, descartados %lu, reinicios %lu, desvio %.2f ppm\n",
+           pps.max_abs, (unsigned long)tb.edges, (unsigned long)tb.edges_matched,
+           (unsigned long)tb.edges_rejected, (unsigned long)tb.resets, tb.drift_ppb * 1e-3);
+    printf("sem PPS por %d s: erro de %.0f a %.0f us\n", (DROPOUT_TO_MS - DROPOUT_FROM_MS) / 1000,
+           pps_dropout.min, pps_dropout.max);
+    if (pps.max_abs > 15.0 || tb.edges_rejected != 1 || tb.resets != 0 || fabs(tb.drift_ppb * 1e-3 - DRIFT_PPM) > 2.0) {
+        failures++;
+    }
+
+    run(false, &envelope, &unused, &tb);
+    printf("pela chegada: erro de %.0f a %.0f us (jitter de chegada %d us + picos de 100 ms)\n",
+           envelope.min, envelope.max, JITTER_US);
+    // Sem PPS sobra o atraso fixo, que se cancela nas diferenças; o jitter precisa sumir
+    if (envelope.max - envelope.min > 2000.0 || envelope.min < 0) {
+        failures++;
+    }
+
+    // Relógio GNSS contínuo: 23:59:59.900 -> 00:00:00.000 avança 100 ms, não volta 24 h
+    GnssClock clock = { 0 };
+    int64_t before = gnss_clock_us(&clock, MS_PER_DAY - 100);
+    int64_t after = gnss_clock_us(&clock, 0);
+    int64_t next = gnss_clock_us(&clock, 100);
+    printf("meia-noite: %+lld us, %+lld us\n", (long long)(after - before), (long long)(next - after));
+    if (after - before != 100000 || next - after != 100000) {
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
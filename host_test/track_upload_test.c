@@ -0,0 +1,184 @@
+// Teste de host da recepção de pista em pedaços: um documento grande (linhas + volta de
+// referência, bem maior que qualquer buffer do firmware) entregue em pedaços de tamanho
+// aleatório, o corpo do formulário do portal e documentos inválidos (inclusive linhas
+// incompletas e coordenadas fora da faixa).
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "track_upload.h"
+
+#define GATES 12
+#define REFERENCE_POINTS 6000
+
+static char *doc;
+static size_t doc_len, doc_size;
+
+static void put(const char *fmt, double a, double b, double c){
+    for (;;) {
+        int n = snprintf(doc + doc_len, doc_size - doc_len, fmt, a, b, c);
+        if ((size_t)n < doc_size - doc_len) {
+            doc_len += n;
+            return;
+        }
+        doc_size *= 2;
+        doc = realloc(doc, doc_size);
+    }
+}
+
+static double gate_lat(int i){
+    return -23.7 + i * 0.001;
+}
+
+static double gate_lon(int i){
+    return -46.6 - i * 0.001;
+}
+
+// Pista completa; as linhas ímpares vêm com as duas extremidades
+static void build_track(void){
+    doc_len = 0;
+    put("{\"nome\": \"Interlagos \\\"curto\\\" \\u00e9\", \"linhas\": [", 0, 0, 0);
+    for (int i = 0; i < GATES; i++) {
+        put(i ? ", {\"lat\": %.7f, \"lon\": %.7f" : "{\"lat\": %.7f, \"lon\": %.7f", gate_lat(i), gate_lon(i), 0);
+        if (i % 2) {
+            put(", \"lat_b\": %.7f, \"lon_b\": %.7f", gate_lat(i) + 0.0001, gate_lon(i) + 0.0001, 0);
+        }
+        put(", \"extra\": {\"x\": [1, 2, true, null]}}", 0, 0, 0);
+    }
+    put("],\n  \"referencia\": [", 0, 0, 0);
+    for (int i = 0; i < REFERENCE_POINTS; i++) {
+        put(i ? ",\n[%.7f, %.7f, %.0f]" : "[%.7f, %.7f, %.0f]", -23.7 + i * 1e-6, -46.6 - i * 1e-6, i * 100.0);
+    }
+    put("]}\n", 0, 0, 0);
+}
+
+// Entrega doc em pedaços aleatórios de 1 a max bytes
+static bool upload(TrackUpload *u, const TrackDef *base, size_t max){
+    track_upload_init(u, base);
+    for (size_t pos = 0; pos < doc_len;) {
+        size_t len = 1 + rand() % max;
+        if (len > doc_len - pos) {
+            len = doc_len - pos;
+        }
+        if (!track_upload_feed(u, doc + pos, len)) {
+            return false;
+        }
+        pos += len;
+    }
+    return track_upload_finish(u);
+}
+
+static bool upload_text(TrackUpload *u, const TrackDef *base, const char *text){
+    doc_len = strlen(text);
+    memcpy(doc, text, doc_len + 1);
+    return upload(u, base, 7);
+}
+
+static int check_track(const TrackUpload *u){
+    int failures = u->track.gate_count != GATES || u->points != REFERENCE_POINTS;
+    for (int i = 0; i < GATES && !failures; i++) {
+        const TrackGate *g = &u->track.gates[i];
+        failures += fabs(g->lat - gate_lat(i)) > 1e-9 || fabs(g->lon - gate_lon(i)) > 1e-9;
+        failures += g->has_line != (i % 2);
+        if (i % 2) {
+            failures += fabs(g->lat_b - gate_lat(i) - 0.0001) > 1e-9 || fabs(g->lon_b - gate_lon(i) - 0.0001) > 1e-9;
+        }
+    }
+    return failures;
+}
+
+int main(void){
+    static TrackUpload u;
+    static const TrackDef empty = { 0 };
+    int failures = 0;
+
+    doc_size = 4096;
+    doc = malloc(doc_size);
+    srand(1);
+
+    // Documento grande em pedaços de vários tamanhos, incluindo o do firmware
+    build_track();
+    size_t sizes[] = { 1, 16, 256, 4096 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bool ok = upload(&u, &empty, sizes[i]);
+        int errors = ok ? check_track(&u) : 1;
+        printf("pista de %zu bytes em pedaços de até %zu: %s, %u linhas, %lu pontos\n", doc_len, sizes[i],
+               errors ? "FALHA" : "ok", u.track.gate_count, (unsigned long)u.points);
+        failures += errors != 0;
+    }
+
+    // Corte no meio do documento: nunca completo
+    size_t full = doc_len;
+    doc_len = full / 2;
+    failures += upload(&u, &empty, 256);
+    doc_len = full;
+
+    // Formulário do portal: altera só os campos preenchidos da pista atual
+    TrackDef base = { .gate_count = 3 };
+    for (int i = 0; i < 3; i++) {
+        base.gates[i] = (TrackGate){ .lat = gate_lat(i), .lon = gate_lon(i) };
+    }
+    base.gates[2].has_line = true;
+    bool ok = upload_text(&u, &base, "{\"lat_start\": \"-23.5\", \"lon_start\": \"-46.5\", \"pos1_lat\": \"\", "
+                                     "\"pos1_long\": \"\", \"pos2_lat\": -23.25, \"pos2_long\": \"\"}");
+    failures += !ok || u.track.gate_count != 3 || u.track.gates[0].lat != -23.5 || u.track.gates[0].lon != -46.5 ||
+                u.track.gates[1].lat != gate_lat(1) || u.track.gates[1].lon != gate_lon(1) ||
+                u.track.gates[2].lat != -23.25 || u.track.gates[2].lon != gate_lon(2) || u.track.gates[2].has_line;
+    printf("formulario: %s\n", ok ? "ok" : "FALHA");
+
+    // Nomes antigos da linha de chegada
+    ok = upload_text(&u, &base, "{\"lin_lat\": \"-22\", \"lin_long\": \"-45\"}");
+    failures += !ok || u.track.gates[0].lat != -22 || u.track.gates[0].lon != -45;
+
+    // Limites das faixas, com a extremidade B
+    ok = upload_text(&u, &empty, "{\"linhas\": [{\"lat\": 90, \"lon\": -180, \"lat_b\": -90, \"lon_b\": 180}]}");
+    failures += !ok || u.track.gate_count != 1 || !u.track.gates[0].has_line || u.track.gates[0].lon_b != 180;
+
+    // Documentos inválidos
+    static const char *invalid[] = {
+        "",
+        "{\"lat_start\": \"-23.5\"",
+        "{\"lat_start\": \"abc\"}",
+        "{\"lat_start\": -23.5,}",
+        "{\"linhas\": [{\"lat\": 1]}",
+        "[1, 2}",
+        "{\"lat_start\": 1} x",
+        "{\"lat_start\": 01x}",
+        "{\"a\": tru}",
+        "{\"a\": \"\\q\"}",
+        // Linhas incompletas ou fora da faixa
+        "{\"linhas\": [{\"lat\": -26.9, \"lng\": -48.9}]}",
+        "{\"linhas\": [{}]}",
+        "{\"linhas\": [{\"lat\": 1, \"lon\": 2}, {}]}",
+        "{\"linhas\": [{\"lat\": 1, \"lon\": 2}, 3]}",
+        "{\"linhas\": [{\"lat\": 900, \"lon\": 2}]}",
+        "{\"linhas\": [{\"lat\": 1, \"lon\": -180.5}]}",
+        "{\"linhas\": [{\"lat\": \"nan\", \"lon\": 2}]}",
+        "{\"linhas\": [{\"lat\": 1, \"lon\": 2, \"lat_b\": 1.001}]}",
+        "{\"linhas\": [{\"lat\": 1, \"lon\": 2, \"lon_b\": 2.001}]}",
+        "{\"lat_start\": \"91\"}",
+        "{\"pos1_long\": 181}",
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        if (upload_text(&u, &base, invalid[i])) {
+            printf("aceito por engano: %s\n", invalid[i]);
+            failures++;
+        }
+    }
+
+    // Mais linhas que o motor comporta
+    doc_len = 0;
+    put("{\"linhas\": [", 0, 0, 0);
+    for (int i = 0; i <= TRACK_MAX_GATES; i++) {
+        put(i ? ", {\"lat\": %.1f, \"lon\": %.1f}" : "{\"lat\": %.1f, \"lon\": %.1f}", i, -i, 0);
+    }
+    put("]}", 0, 0, 0);
+    failures += upload(&u, &empty, 64);
+
+    // Aninhamento maior que JSON_STREAM_DEPTH
+    failures += upload_text(&u, &empty, "[[[[[[[[[[1]]]]]]]]]]");
+
+    free(doc);
+    printf("%s\n", failures ? "FALHOU" : "OK");
+    return failures ? 1 : 0;
+}
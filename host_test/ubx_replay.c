@@ -0,0 +1,162 @@
+// Teste de host do caminho UBX: reproduz uma captura binária de NAV-PVT em pedaços de tamanho
+// aleatório, como chegam da UART, e confere que o motor de voltas mede as mesmas voltas da
+// sessão NMEA equivalente. Também corrompe um quadro para conferir o descarte por checksum e
+// confere a resposta ao MON-VER, maior que o buffer de payload, usada para detectar o u-blox.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nmea.h"
+#include "ubx.h"
+#include "lap_engine.h"
+
+#define MAX_LAPS 16
+#define LAP_TOLERANCE_US 5000   // A sessão NMEA tem resolução de ~2 cm na posição
+
+typedef struct {
+    int fixes;
+    int laps;
+    int64_t lap_us[MAX_LAPS];
+} Replay;
+
+// O horário UTC do fix serve de relógio, para as duas capturas ficarem na mesma base de tempo
+static void on_fix(const GnssFix *fix, void *ctx){
+    Replay *r = (Replay *)ctx;
+    int64_t before = lap_last.lap_us;
+
+    if (!fix->valid) {
+        return;
+    }
+    r->fixes++;
+    process_position(fix->lat_e7, fix->lon_e7, (int64_t)fix->utc_ms * 1000);
+    if (lap_last.lap_us != before && r->laps < MAX_LAPS) {
+        r->lap_us[r->laps++] = lap_last.lap_us;
+    }
+}
+
+static uint8_t *read_file(const char *path, size_t *size){
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        perror(path);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *size = (size_t)ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *data = malloc(*size + 1);
+    if (data && fread(data, 1, *size, fp) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    return data;
+}
+
+static void replay_nmea(char *text, size_t size, Replay *r){
+    NmeaEpoch epoch;
+    nmea_epoch_init(&epoch, on_fix, r);
+    lap_engine_load_track(lap_engine_track());
+
+    text[size] = '\0';
+    for (char *line = strtok(text, "\r\n"); line; line = strtok(NULL, "\r\n")) {
+        nmea_epoch_feed(&epoch, line, strlen(line), 0);
+    }
+}
+
+static void replay_ubx(const uint8_t *data, size_t size, Replay *r, UbxParser *parser){
+    ubx_parser_init(parser, on_fix, r);
+    lap_engine_load_track(lap_engine_track());
+
+    // Pedaços de 1 a 64 bytes, para quadros partidos em qualquer ponto
+    srand(1234);
+    for (size_t pos = 0; pos < size;) {
+        size_t chunk = 1 + (size_t)(rand() % 64);
+        if (chunk > size - pos) {
+            chunk = size - pos;
+        }
+        ubx_parser_feed(parser, data + pos, chunk, 0);
+        pos += chunk;
+    }
+}
+
+int main(int argc, char **argv){
+    if (argc < 3) {
+        fprintf(stderr, "uso: %s sessao.ubx sessao.nmea\n", argv[0]);
+        return 2;
+    }
+
+    size_t ubx_size, nmea_size;
+    uint8_t *ubx_data = read_file(argv[1], &ubx_size);
+    uint8_t *nmea_data = read_file(argv[2], &nmea_size);
+    if (!ubx_data || !nmea_data) {
+        return 2;
+    }
+
+    Replay nmea = { 0 }, ubx = { 0 };
+    UbxParser parser;
+    int failures = 0;
+
+    replay_nmea((char *)nmea_data, nmea_size, &nmea);
+    replay_ubx(ubx_data, ubx_size, &ubx, &parser);
+
+    printf("ubx: %lu quadros, %lu checksum, %lu bytes fora de quadro, %d fixes, %d voltas\n",
+           (unsigned long)parser.frames, (unsigned long)parser.bad_checksum,
+           (unsigned long)parser.skipped, ubx.fixes, ubx.laps);
+    printf("nmea: %d fixes, %d voltas\n", nmea.fixes, nmea.laps);
+
+    if (parser.bad_checksum != 0 || ubx.fixes != nmea.fixes || ubx.laps != nmea.laps || ubx.laps == 0) {
+        failures++;
+    }
+    for (int i = 0; i < ubx.laps && i < nmea.laps; i++) {
+        int64_t diff = llabs(ubx.lap_us[i] - nmea.lap_us[i]);
+        printf("volta %d: ubx %.3f s, nmea %.3f s\n", i + 1, ubx.lap_us[i] * 1e-6, nmea.lap_us[i] * 1e-6);
+        if (diff > LAP_TOLERANCE_US) {
+            failures++;
+        }
+    }
+
+    // Um byte trocado no payload do primeiro quadro: só ele é descartado
+    int fixes = ubx.fixes;
+    ubx_data[20] ^= 0x5A;
+    ubx = (Replay){ 0 };
+    replay_ubx(ubx_data, ubx_size, &ubx, &parser);
+    printf("corrompido: %lu checksum, %d fixes\n", (unsigned long)parser.bad_checksum, ubx.fixes);
+    if (parser.bad_checksum != 1 || ubx.fixes != fixes - 1) {
+        failures++;
+    }
+
+    // Resposta ao MON-VER de um M8 (40 bytes de versões + 30 por extensão, 190 no total) no meio
+    // de NMEA, seguida de um NAV-PVT da captura: os dois contam como quadros e o NAV-PVT é lido
+    static const char *MON_VER_TEXT[] = {
+        "ROM CORE 3.01 (107888)", "00080000", "FWVER=SPG 3.01", "PROTVER=18.00",
+        "GPS;GLO;GAL;BDS", "SBAS;IMES;QZSS", "GNSS OTP=GPS;GLO",
+    };
+    uint8_t payload[190] = { 0 }, frame[sizeof(payload) + 8];
+    memcpy(payload, MON_VER_TEXT[0], strlen(MON_VER_TEXT[0]));
+    memcpy(payload + 30, MON_VER_TEXT[1], strlen(MON_VER_TEXT[1]));
+    for (int i = 2; i < 7; i++) {
+        memcpy(payload + 40 + (i - 2) * 30, MON_VER_TEXT[i], strlen(MON_VER_TEXT[i]));
+    }
+    size_t frame_len = ubx_build_frame(frame, sizeof(frame), UBX_CLASS_MON, UBX_ID_MON_VER, payload, sizeof(payload));
+    static const char NMEA_LINE[] = "$GNTXT,01,01,02,u-blox AG - www.u-blox.com*4E\r\n";
+
+    ubx = (Replay){ 0 };
+    ubx_parser_init(&parser, on_fix, &ubx);
+    ubx_parser_feed(&parser, (const uint8_t *)NMEA_LINE, strlen(NMEA_LINE), 0);
+    for (size_t pos = 0; pos < frame_len; pos += 17) {
+        ubx_parser_feed(&parser, frame + pos, frame_len - pos < 17 ? frame_len - pos : 17, 0);
+    }
+    bool mon_ver = parser.frames == 1 && parser.last_class == UBX_CLASS_MON && parser.last_id == UBX_ID_MON_VER;
+    ubx_data[20] ^= 0x5A; // Desfaz a corrupção do primeiro NAV-PVT
+    ubx_parser_feed(&parser, ubx_data, 8 + UBX_NAV_PVT_LEN, 0);
+    printf("mon-ver: %zu bytes, %lu quadros, %lu grandes, %lu checksum, %d fixes\n", frame_len,
+           (unsigned long)parser.frames, (unsigned long)parser.oversized, (unsigned long)parser.bad_checksum,
+           ubx.fixes);
+    if (!mon_ver || parser.frames != 2 || parser.oversized != 1 || parser.bad_checksum != 0 ||
+        parser.last_class != UBX_CLASS_NAV || ubx.fixes != 1) {
+        failures++;
+    }
+
+    free(ubx_data);
+    free(nmea_data);
+    return failures ? 1 : 0;
+}
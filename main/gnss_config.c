@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "line_assembler.h"
+#include "ubx.h"
+#include "gnss_config.h"
+
+static const char *TAG = "GNSS";
+
+// Baud rates testados na procura do receptor, depois da taxa de trabalho
+static const int PROBE_BAUDS[] = { 9600, 38400, 57600, 115200, 230400 };
+#define PROBE_BAUD_COUNT (sizeof(PROBE_BAUDS) / sizeof(PROBE_BAUDS[0]))
+
+#define PROBE_WINDOW_MS 1200        // Cobre ao menos uma época a 1 Hz
+#define REPLY_WINDOW_MS 600         // Espera pela resposta a um comando de consulta
+#define COMMAND_GAP_MS 50           // Intervalo entre comandos, para o receptor processar cada um
+
+#define NMEA_EPOCH_BYTES 150        // RMC + GGA por época
+#define UBX_EPOCH_BYTES 100         // NAV-PVT por época
+
+// Bytes lidos durante a procura: a mesma entrada vai ao montador de linhas (NMEA com checksum
+// conferido) e ao leitor UBX, e o que for reconhecido indica o baud rate certo
+typedef struct {
+    LineAssembler lines;
+    UbxParser ubx;
+    uint32_t nmea_lines;                            // Linhas NMEA com checksum correto
+    bool (*match)(const char *line, size_t len);    // Resposta esperada a um comando, ou NULL
+    uint8_t ubx_class, ubx_id;                      // Resposta UBX esperada (classe 0: nenhuma)
+    bool matched;
+} Probe;
+
+const char *gnss_family_name(GnssFamily family){
+    switch (family) {
+    case GNSS_FAMILY_UBLOX: return "u-blox";
+    case GNSS_FAMILY_MTK: return "MediaTek";
+    case GNSS_FAMILY_CASIC: return "CASIC";
+    default: return "desconhecido";
+    }
+}
+
+static void probe_reset(Probe *p, bool (*match)(const char *line, size_t len)){
+    line_asm_init(&p->lines);
+    ubx_parser_init(&p->ubx, NULL, NULL);
+    p->nmea_lines = 0;
+    p->match = match;
+    p->ubx_class = p->ubx_id = 0;
+    p->matched = false;
+}
+
+// Lê a UART durante window_ms, contando linhas NMEA e quadros UBX válidos
+static void probe_listen(uart_port_t port, Probe *p, int window_ms){
+    int64_t deadline = esp_timer_get_time() + (int64_t)window_ms * 1000;
+
+    while (esp_timer_get_time() < deadline && !p->matched) {
+        size_t space;
+        char *dst = line_asm_reserve(&p->lines, &space);
+        int rxBytes = uart_read_bytes(port, dst, space, pdMS_TO_TICKS(20));
+        if (rxBytes <= 0) {
+            continue;
+        }
+        if (ubx_parser_feed(&p->ubx, (const uint8_t *)dst, rxBytes, 0) && p->ubx_class &&
+            p->ubx.last_class == p->ubx_class && p->ubx.last_id == p->ubx_id) {
+            p->matched = true;
+        }
+        line_asm_commit(&p->lines, rxBytes);
+
+        const char *line;
+        size_t len;
+        while (line_asm_next(&p->lines, &line, &len)) {
+            p->nmea_lines++;
+            if (p->match && p->match(line, len)) {
+                p->matched = true;
+            }
+        }
+    }
+}
+
+static bool probe_has_data(const Probe *p){
+    return p->nmea_lines >= 2 || p->ubx.frames >= 1;
+}
+
+// Envia um comando NMEA proprietário; body vai sem o '$' e sem o checksum
+static void send_nmea(uart_port_t port, const char *body){
+    char buf[96];
+    uint8_t cs = 0;
+
+    for (const char *c = body; *c; c++) {
+        cs ^= (uint8_t)*c;
+    }
+    int len = snprintf(buf, sizeof(buf), "$%s*%02X\r\n", body, cs);
+    uart_write_bytes(port, buf, len);
+    uart_wait_tx_done(port, pdMS_TO_TICKS(100));
+    vTaskDelay(pdMS_TO_TICKS(COMMAND_GAP_MS));
+}
+
+static void send_ubx(uart_port_t port, uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t len){
+    uint8_t frame[UBX_MAX_PAYLOAD + 8];
+    size_t size = ubx_build_frame(frame, sizeof(frame), msg_class, msg_id, payload, len);
+
+    if (size) {
+        uart_write_bytes(port, frame, size);
+        uart_wait_tx_done(port, pdMS_TO_TICKS(100));
+        vTaskDelay(pdMS_TO_TICKS(COMMAND_GAP_MS));
+    }
+}
+
+// Resposta ao $PMTK605 (versão do firmware MediaTek)
+static bool match_mtk(const char *line, size_t len){
+    return len >= 8 && strncmp(line, "$PMTK705", 8) == 0;
+}
+
+// Resposta ao $PCAS06,0 (versão do firmware CASIC): $GPTXT/$GNTXT com "SW="
+static bool match_casic(const char *line, size_t len){
+    return len >= 6 && strncmp(line + 3, "TXT", 3) == 0 && strstr(line, "SW=") != NULL;
+}
+
+// Procura o receptor: primeiro na taxa de trabalho (que ele pode ter guardado), depois nas demais
+static int detect_baud(uart_port_t port, Probe *p, int target_baud){
+    int candidates[PROBE_BAUD_COUNT + 1];
+    int count = 0;
+
+    candidates[count++] = target_baud;
+    for (size_t i = 0; i < PROBE_BAUD_COUNT; i++) {
+        if (PROBE_BAUDS[i] != target_baud) {
+            candidates[count++] = PROBE_BAUDS[i];
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        uart_set_baudrate(port, candidates[i]);
+        uart_flush_input(port);
+        probe_reset(p, NULL);
+        probe_listen(port, p, PROBE_WINDOW_MS);
+        if (probe_has_data(p)) {
+            return candidates[i];
+        }
+    }
+    return 0;
+}
+
+// Identifica a família pela resposta a uma consulta de versão de cada conjunto de comandos
+static GnssFamily detect_family(uart_port_t port, Probe *p){
+    if (p->ubx.frames) {
+        return GNSS_FAMILY_UBLOX; // Já está enviando UBX
+    }
+
+    // A resposta ao MON-VER tem 130 a 220+ bytes (strings de extensão): o leitor confere o
+    // checksum e guarda a classe e o id, sem copiar o payload
+    uart_flush_input(port);
+    probe_reset(p, NULL);
+    p->ubx_class = UBX_CLASS_MON;
+    p->ubx_id = UBX_ID_MON_VER;
+    send_ubx(port, UBX_CLASS_MON, UBX_ID_MON_VER, NULL, 0);
+    probe_listen(port, p, REPLY_WINDOW_MS);
+    if (p->matched) {
+        return GNSS_FAMILY_UBLOX;
+    }
+
+    probe_reset(p, match_mtk);
+    send_nmea(port, "PMTK605");
+    probe_listen(port, p, REPLY_WINDOW_MS);
+    if (p->matched) {
+        return GNSS_FAMILY_MTK;
+    }
+
+    probe_reset(p, match_casic);
+    send_nmea(port, "PCAS06,0");
+    probe_listen(port, p, REPLY_WINDOW_MS);
+    if (p->matched) {
+        return GNSS_FAMILY_CASIC;
+    }
+    return GNSS_FAMILY_UNKNOWN;
+}
+
+// Acrescenta um par chave/valor ao payload de um UBX-CFG-VALSET; o tamanho vem da própria chave
+static void valset_add(uint8_t *buf, uint16_t *len, uint32_t key, uint32_t value){
+    static const uint8_t SIZE_BYTES[8] = { 0, 1, 1, 2, 4, 8, 0, 0 };
+    uint8_t size = SIZE_BYTES[(key >> 28) & 7];
+
+    for (int i = 0; i < 4; i++) {
+        buf[(*len)++] = (key >> (8 * i)) & 0xFF;
+    }
+    for (int i = 0; i < size && i < 4; i++) {
+        buf[(*len)++] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+// u-blox: manda os comandos das duas gerações de configuração. A série 6/7/8 usa CFG-RATE,
+// CFG-MSG e CFG-PRT; a 9/10 usa CFG-VALSET. Cada uma responde NAK ao que não conhece.
+static void configure_ublox(uart_port_t port, int baud, int rate_hz, bool ubx_output){
+    uint16_t meas_ms = 1000 / rate_hz;
+
+    const uint8_t rate[6] = { meas_ms & 0xFF, meas_ms >> 8, 1, 0, 1, 0 }; // Medição, 1 ciclo, hora GPS
+    send_ubx(port, UBX_CLASS_CFG, UBX_ID_CFG_RATE, rate, sizeof(rate));
+
+    // Sentenças NMEA na ordem dos ids 0xF0: GGA, GLL, GSA, GSV, RMC, VTG. Só RMC e GGA ficam.
+    static const bool NMEA_KEEP[6] = { true, false, false, false, true, false };
+    for (uint8_t id = 0; id < 6; id++) {
+        const uint8_t msg[3] = { UBX_CLASS_NMEA, id, (!ubx_output && NMEA_KEEP[id]) ? 1 : 0 };
+        send_ubx(port, UBX_CLASS_CFG, UBX_ID_CFG_MSG, msg, sizeof(msg));
+    }
+    const uint8_t pvt[3] = { UBX_CLASS_NAV, UBX_ID_NAV_PVT, ubx_output ? 1 : 0 };
+    send_ubx(port, UBX_CLASS_CFG, UBX_ID_CFG_MSG, pvt, sizeof(pvt));
+
+    // CFG-VALSET na RAM: versão 0, camada 1, 2 bytes reservados e os pares chave/valor
+    uint8_t valset[UBX_MAX_PAYLOAD] = { 0x00, 0x01, 0x00, 0x00 };
+    uint16_t len = 4;
+    valset_add(valset, &len, 0x30210001, meas_ms);              // CFG-RATE-MEAS
+    valset_add(valset, &len, 0x209100bb, !ubx_output);          // CFG-MSGOUT-NMEA_ID_GGA_UART1
+    valset_add(valset, &len, 0x209100ca, 0);                    // GLL
+    valset_add(valset, &len, 0x209100c0, 0);                    // GSA
+    valset_add(valset, &len, 0x209100c5, 0);                    // GSV
+    valset_add(valset, &len, 0x209100ac, !ubx_output);          // RMC
+    valset_add(valset, &len, 0x209100b1, 0);                    // VTG
+    valset_add(valset, &len, 0x20910007, ubx_output);           // CFG-MSGOUT-UBX_NAV_PVT_UART1
+    valset_add(valset, &len, 0x10740001, 1);                    // CFG-UART1OUTPROT-UBX
+    valset_add(valset, &len, 0x10740002, !ubx_output);          // CFG-UART1OUTPROT-NMEA
+    send_ubx(port, UBX_CLASS_CFG, UBX_ID_CFG_VALSET, valset, len);
+
+    // Baud rate por último: a resposta a ele já sai na taxa nova
+    const uint8_t prt[20] = {
+        1, 0, 0, 0,                                         // UART1, txReady desligado
+        0xD0, 0x08, 0x00, 0x00,                             // 8N1
+        baud & 0xFF, (baud >> 8) & 0xFF, (baud >> 16) & 0xFF, (baud >> 24) & 0xFF,
+        0x03, 0x00,                                         // Entrada UBX + NMEA
+        ubx_output ? 0x01 : 0x02, 0x00,                     // Saída só UBX ou só NMEA
+        0, 0, 0, 0,
+    };
+    send_ubx(port, UBX_CLASS_CFG, UBX_ID_CFG_PRT, prt, sizeof(prt));
+
+    len = 4;
+    valset_add(valset, &len, 0x40520001, baud);                 // CFG-UART1-BAUDRATE
+    send_ubx(port, UBX_CLASS_CFG, UBX_ID_CFG_VALSET, valset, len);
+}
+
+// MediaTek (MT3339 e similares): só RMC e GGA, intervalo de fix e baud rate
+static void configure_mtk(uart_port_t port, int baud, int rate_hz){
+    char cmd[64];
+    int interval_ms = 1000 / rate_hz;
+
+    send_nmea(port, "PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0"); // GLL,RMC,VTG,GGA,GSA,GSV...
+    snprintf(cmd, sizeof(cmd), "PMTK220,%d", interval_ms);
+    send_nmea(port, cmd);
+    snprintf(cmd, sizeof(cmd), "PMTK300,%d,0,0,0,0", interval_ms);
+    send_nmea(port, cmd);
+    snprintf(cmd, sizeof(cmd), "PMTK251,%d", baud);
+    send_nmea(port, cmd);
+}
+
+// CASIC (AT6558 e similares): só RMC e GGA, intervalo de fix e baud rate pelo índice da tabela
+static void configure_casic(uart_port_t port, int baud, int rate_hz){
+    static const int CASIC_BAUDS[] = { 4800, 9600, 19200, 38400, 57600, 115200 };
+    char cmd[64];
+    int index = 5;
+
+    for (int i = 0; i < (int)(sizeof(CASIC_BAUDS) / sizeof(CASIC_BAUDS[0])); i++) {
+        if (CASIC_BAUDS[i] == baud) {
+            index = i;
+        }
+    }
+
+    send_nmea(port, "PCAS03,1,0,0,0,1,0,0,0,0,0,,,0,0"); // GGA,GLL,GSA,GSV,RMC,VTG,ZDA,ANT,DHV,LPS,,,UTC,GST
+    snprintf(cmd, sizeof(cmd), "PCAS02,%d", 1000 / rate_hz);
+    send_nmea(port, cmd);
+    snprintf(cmd, sizeof(cmd), "PCAS01,%d", index);
+    send_nmea(port, cmd);
+}
+
+// Procura o receptor, identifica a família e pede baud rate, taxa e mensagens de trabalho.
+// Ao final a UART fica no baud rate em que o receptor respondeu; se o receptor não aparecer
+// na taxa nova, volta para a anterior. Bloqueia por alguns segundos: roda só na inicialização,
+// antes da task de leitura da UART.
+GnssConfig gnss_config_run(uart_port_t port, int target_baud, int rate_hz, bool ubx_output){
+    GnssConfig result = { .family = GNSS_FAMILY_UNKNOWN, .baud = 0, .rate_hz = 0 };
+
+    Probe *p = (Probe *)malloc(sizeof(Probe));
+    if (!p) {
+        ESP_LOGE(TAG, "Failed to allocate memory for receiver probe");
+        return result;
+    }
+
+    int baud = detect_baud(port, p, target_baud);
+    if (!baud) {
+        ESP_LOGE(TAG, "Receptor nao encontrado em nenhum baud rate");
+        uart_set_baudrate(port, PROBE_BAUDS[0]);
+        free(p);
+        return result;
+    }
+    result.baud = baud;
+    result.family = detect_family(port, p);
+    ESP_LOGI(TAG, "Receptor %s a %d baud", gnss_family_name(result.family), baud);
+
+    // Limites de cada família
+    int max_baud = 115200, max_rate = 10;
+    if (result.family == GNSS_FAMILY_UBLOX) {
+        max_baud = 230400;
+        max_rate = 25;
+    }
+    if (target_baud > max_baud) {
+        target_baud = max_baud;
+    }
+    if (rate_hz > max_rate) {
+        rate_hz = max_rate;
+    }
+    // A taxa precisa caber no baud rate com folga (10 bits por byte, 70% de ocupação)
+    int epoch_bytes = ubx_output ? UBX_EPOCH_BYTES : NMEA_EPOCH_BYTES;
+    int fit_rate = target_baud / 10 * 7 / 10 / epoch_bytes;
+    if (rate_hz > fit_rate) {
+        rate_hz = fit_rate > 0 ? fit_rate : 1;
+    }
+
+    if (ubx_output && result.family != GNSS_FAMILY_UBLOX) {
+        ESP_LOGE(TAG, "Receptor sem UBX: escolha NMEA no menuconfig");
+    }
+
+    switch (result.family) {
+    case GNSS_FAMILY_UBLOX:
+        configure_ublox(port, target_baud, rate_hz, ubx_output);
+        break;
+    case GNSS_FAMILY_MTK:
+        configure_mtk(port, target_baud, rate_hz);
+        break;
+    case GNSS_FAMILY_CASIC:
+        configure_casic(port, target_baud, rate_hz);
+        break;
+    default:
+        // Sem comandos conhecidos: segue no baud rate e na taxa atuais do receptor
+        free(p);
+        return result;
+    }
+    result.rate_hz = rate_hz;
+
+    // Acompanha o receptor no baud rate novo e confere que os dados continuam chegando
+    if (target_baud != baud) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+        uart_set_baudrate(port, target_baud);
+        uart_flush_input(port);
+        probe_reset(p, NULL);
+        probe_listen(port, p, PROBE_WINDOW_MS);
+        if (probe_has_data(p)) {
+            result.baud = target_baud;
+        } else {
+            ESP_LOGW(TAG, "Sem dados a %d baud, voltando para %d", target_baud, baud);
+            uart_set_baudrate(port, baud);
+        }
+    }
+
+    ESP_LOGI(TAG, "Trabalhando a %d baud, %d Hz", result.baud, result.rate_hz);
+    free(p);
+    return result;
+}
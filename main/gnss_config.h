@@ -0,0 +1,26 @@
+#ifndef GNSS_CONFIG_H
+#define GNSS_CONFIG_H
+
+#include <stdbool.h>
+#include "driver/uart.h"
+
+// Família do receptor, identificada pela resposta aos comandos de consulta
+typedef enum {
+    GNSS_FAMILY_UNKNOWN,    // Envia NMEA, mas não respondeu a nenhum comando conhecido
+    GNSS_FAMILY_UBLOX,      // u-blox: UBX-CFG
+    GNSS_FAMILY_MTK,        // MediaTek: PMTK
+    GNSS_FAMILY_CASIC,      // AT6558 e similares: PCAS
+} GnssFamily;
+
+// Resultado da configuração do receptor
+typedef struct {
+    GnssFamily family;
+    int baud;               // Baud rate em uso, já aplicado à UART (0 = receptor não encontrado)
+    int rate_hz;            // Taxa de navegação pedida ao receptor
+} GnssConfig;
+
+const char *gnss_family_name(GnssFamily family);
+
+GnssConfig gnss_config_run(uart_port_t port, int target_baud, int rate_hz, bool ubx_output);
+
+#endif // GNSS_CONFIG_H
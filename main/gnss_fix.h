@@ -0,0 +1,44 @@
+#ifndef GNSS_FIX_H
+#define GNSS_FIX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Campos presentes em um GnssFix, conforme as sentenças recebidas na época
+#define GNSS_HAS_POSITION   (1u << 0)
+#define GNSS_HAS_SPEED      (1u << 1)
+#define GNSS_HAS_COURSE     (1u << 2)
+#define GNSS_HAS_DATE       (1u << 3)
+#define GNSS_HAS_QUALITY    (1u << 4)   // Qualidade, satélites, HDOP (GGA)
+#define GNSS_HAS_ALTITUDE   (1u << 5)
+#define GNSS_HAS_DOP        (1u << 6)   // Tipo de fix, PDOP/VDOP (GSA)
+#define GNSS_HAS_ERROR      (1u << 7)   // Desvio padrão da posição (GST)
+#define GNSS_HAS_TOW        (1u << 8)   // Tempo da semana GPS (UBX NAV-PVT)
+
+// Um fix por época de navegação, montado a partir de todas as sentenças com o mesmo horário
+typedef struct {
+    uint32_t fields;            // Máscara GNSS_HAS_*
+    bool valid;                 // Posição utilizável (RMC 'A' ou GGA com qualidade > 0)
+    bool malformed;             // Alguma coordenada da época estava malformada: nunca é válida
+    uint32_t utc_ms;            // Horário UTC da medição, em milissegundos do dia
+    uint32_t itow_ms;           // Tempo da semana GPS da época (só no UBX)
+    int64_t local_us;           // esp_timer na chegada da primeira sentença da época
+    int64_t complete_us;        // esp_timer na chegada da sentença (ou quadro) que completou a época
+    int32_t lat_e7;             // Latitude em 1e-7 grau, negativa no hemisfério sul
+    int32_t lon_e7;             // Longitude em 1e-7 grau, negativa a oeste
+    float speed_kmh;            // Velocidade em km/h
+    float course_deg;           // Rumo verdadeiro em graus
+    float altitude_m;           // Altitude acima do nível do mar
+    float hdop, pdop, vdop;     // Diluições de precisão
+    float lat_err_m, lon_err_m; // Desvio padrão estimado da posição
+    uint8_t quality;            // Qualidade do fix no GGA (0 = inválido, 1 = GPS, 2 = DGPS...)
+    uint8_t fix_type;           // Tipo de fix no GSA (1 = sem fix, 2 = 2D, 3 = 3D)
+    uint8_t satellites;         // Satélites em uso
+    uint8_t day, month;         // Data UTC
+    uint16_t year;
+} GnssFix;
+
+// Recebe cada fix completo, seja do montador NMEA ou do decodificador UBX
+typedef void (*gnss_fix_cb)(const GnssFix *fix, void *ctx);
+
+#endif // GNSS_FIX_H
@@ -0,0 +1,63 @@
+#include "lap_engine.h"
+#include "lap_events.h"
+#include "gnss_pipeline.h"
+
+// Cada fix completo: atualiza a base de tempo, escolhe o relógio da cronometragem e passa a
+// posição ao motor de voltas
+static void pipeline_fix(const GnssFix *fix, void *ctx){
+    GnssPipeline *p = (GnssPipeline *)ctx;
+    bool has_time = fix->utc_ms != UINT32_MAX;
+
+    timebase_fix(&p->timebase, fix->utc_ms, fix->local_us);
+
+    int64_t epoch_us = fix->local_us;
+    if (p->timebase.locked && has_time) {
+        epoch_us = timebase_to_local(&p->timebase, fix->utc_ms);
+    }
+
+    // Pelo horário GNSS, carga de CPU, UART ou WiFi não entram nos tempos de volta
+    int64_t timing_us = epoch_us;
+    if (p->gnss_time && has_time) {
+        timing_us = gnss_clock_us(&p->clock, fix->utc_ms);
+    }
+
+    if (fix->valid && (has_time || !p->gnss_time)) {
+        p->fixes++;
+        process_position(fix->lat_e7, fix->lon_e7, timing_us);
+    } else if (!fix->valid && p->has_position) {
+        LapEvent event = { .type = LAP_EVENT_FIX_LOST, .lap = lap_state.lap, .time_us = timing_us };
+        lap_events_publish(&event);
+    }
+    p->has_position = fix->valid;
+
+    if (p->on_fix) {
+        p->on_fix(fix, epoch_us, p->ctx);
+    }
+}
+
+void gnss_pipeline_init(GnssPipeline *p, bool gnss_time, gnss_pipeline_cb on_fix, void *ctx){
+    nmea_epoch_init(&p->nmea, pipeline_fix, p);
+    ubx_parser_init(&p->ubx, pipeline_fix, p);
+    timebase_init(&p->timebase);
+    p->clock = (GnssClock){ 0 };
+    p->gnss_time = gnss_time;
+    p->has_position = false;
+    p->on_fix = on_fix;
+    p->ctx = ctx;
+    p->fixes = 0;
+}
+
+// Borda de subida do PPS, já datada no esp_timer
+void gnss_pipeline_pps_edge(GnssPipeline *p, int64_t edge_us){
+    timebase_pps_edge(&p->timebase, edge_us);
+}
+
+// Uma linha NMEA completa; arrival_us é a chegada do fim da linha
+void gnss_pipeline_nmea_line(GnssPipeline *p, const char *line, size_t len, int64_t arrival_us){
+    nmea_epoch_feed(&p->nmea, line, len, arrival_us);
+}
+
+// Bytes de um fluxo UBX, em pedaços de qualquer tamanho
+void gnss_pipeline_ubx(GnssPipeline *p, const uint8_t *data, size_t len, int64_t arrival_us){
+    ubx_parser_feed(&p->ubx, data, len, arrival_us);
+}
@@ -0,0 +1,34 @@
+#ifndef GNSS_PIPELINE_H
+#define GNSS_PIPELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "gnss_fix.h"
+#include "nmea.h"
+#include "ubx.h"
+#include "timebase.h"
+
+// Recebe cada fix depois do motor de voltas; epoch_us é o esp_timer estimado da medição
+typedef void (*gnss_pipeline_cb)(const GnssFix *fix, int64_t epoch_us, void *ctx);
+
+// Caminho das mensagens do receptor até o motor de voltas. Não depende do ESP-IDF: o firmware
+// e o replay de host passam pelo mesmo código.
+typedef struct {
+    NmeaEpoch nmea;             // Sentenças NMEA -> um fix por época
+    UbxParser ubx;              // Quadros UBX -> um fix por NAV-PVT
+    Timebase timebase;          // Horário GNSS -> esp_timer
+    GnssClock clock;            // Horário GNSS contínuo
+    bool gnss_time;             // Cronometra pelo horário GNSS (senão pelo esp_timer da medição)
+    bool has_position;          // O último fix tinha posição (para o evento de sinal perdido)
+    gnss_pipeline_cb on_fix;
+    void *ctx;
+    uint32_t fixes;             // Fixes válidos entregues ao motor
+} GnssPipeline;
+
+void gnss_pipeline_init(GnssPipeline *p, bool gnss_time, gnss_pipeline_cb on_fix, void *ctx);
+void gnss_pipeline_pps_edge(GnssPipeline *p, int64_t edge_us);
+void gnss_pipeline_nmea_line(GnssPipeline *p, const char *line, size_t len, int64_t arrival_us);
+void gnss_pipeline_ubx(GnssPipeline *p, const uint8_t *data, size_t len, int64_t arrival_us);
+
+#endif // GNSS_PIPELINE_H
@@ -0,0 +1,269 @@
+#include <stdlib.h>
+#include <string.h>
+#include "json_stream.h"
+
+enum {
+    ST_VALUE,           // Espera um valor
+    ST_ARRAY_FIRST,     // Depois de '[': valor ou ']'
+    ST_OBJECT_FIRST,    // Depois de '{': chave ou '}'
+    ST_KEY,             // Depois de ',' num objeto: chave
+    ST_COLON,           // Depois da chave
+    ST_AFTER,           // Depois de um valor: ',' ou o fechamento do nível
+    ST_STRING,
+    ST_ESCAPE,          // Depois de '\' numa string
+    ST_UNICODE,         // Nos dígitos de um \uXXXX
+    ST_LITERAL,         // Número, true, false ou null
+    ST_DONE,
+    ST_ERROR,
+};
+
+void json_stream_init(JsonStream *js, json_value_cb callback, void *ctx){
+    memset(js, 0, sizeof(*js));
+    js->state = ST_VALUE;
+    js->callback = callback;
+    js->ctx = ctx;
+}
+
+static void text_reset(JsonStream *js){
+    js->text_len = 0;
+    js->text[0] = '\0';
+}
+
+static void text_append(JsonStream *js, char c){
+    if (js->text_len < JSON_STREAM_VALUE_MAX - 1) {
+        js->text[js->text_len++] = c;
+        js->text[js->text_len] = '\0';
+    } else {
+        js->truncated = true;
+    }
+}
+
+// Um valor (escalar, objeto ou lista) terminou
+static void value_done(JsonStream *js){
+    js->state = js->depth == 0 ? ST_DONE : ST_AFTER;
+}
+
+static bool push(JsonStream *js, bool array){
+    if (js->depth == JSON_STREAM_DEPTH) {
+        return false;
+    }
+    js->level[js->depth++] = (JsonLevel){ .array = array };
+    return true;
+}
+
+static void emit(JsonStream *js, JsonValueType type){
+    if (js->callback) {
+        js->callback(js, type, js->text, js->ctx);
+    }
+}
+
+// Classifica e confere o literal acumulado
+static bool literal_end(JsonStream *js){
+    const char *t = js->text;
+
+    if (js->truncated) {
+        return false;
+    }
+    if (strcmp(t, "true") == 0) {
+        emit(js, JSON_TRUE);
+    } else if (strcmp(t, "false") == 0) {
+        emit(js, JSON_FALSE);
+    } else if (strcmp(t, "null") == 0) {
+        emit(js, JSON_NULL);
+    } else {
+        char *end;
+        if ((t[0] != '-' && (t[0] < '0' || t[0] > '9')) || strspn(t, "0123456789+-.eE") != js->text_len) {
+            return false;
+        }
+        strtod(t, &end);
+        if (*end != '\0') {
+            return false;
+        }
+        emit(js, JSON_NUMBER);
+    }
+    value_done(js);
+    return true;
+}
+
+static bool is_space(char c){
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_literal_char(char c){
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+// Início de um valor em qualquer posição que aceite um
+static bool value_start(JsonStream *js, char c){
+    switch (c) {
+    case '{':
+        js->state = ST_OBJECT_FIRST;
+        return push(js, false);
+    case '[':
+        js->state = ST_ARRAY_FIRST;
+        return push(js, true);
+    case '"':
+        js->in_key = false;
+        js->truncated = false;
+        text_reset(js);
+        js->state = ST_STRING;
+        return true;
+    default:
+        if (c != '-' && (c < '0' || c > '9') && c != 't' && c != 'f' && c != 'n') {
+            return false;
+        }
+        js->truncated = false;
+        text_reset(js);
+        text_append(js, c);
+        js->state = ST_LITERAL;
+        return true;
+    }
+}
+
+static bool key_start(JsonStream *js, char c){
+    if (c != '"') {
+        return false;
+    }
+    js->in_key = true;
+    js->truncated = false;
+    text_reset(js);
+    js->state = ST_STRING;
+    return true;
+}
+
+static bool string_end(JsonStream *js){
+    if (js->in_key) {
+        JsonLevel *top = &js->level[js->depth - 1];
+        size_t len = js->text_len < sizeof(top->key) - 1 ? js->text_len : sizeof(top->key) - 1;
+        memcpy(top->key, js->text, len);
+        top->key[len] = '\0';
+        js->state = ST_COLON;
+    } else {
+        emit(js, JSON_STRING);
+        value_done(js);
+    }
+    return true;
+}
+
+static bool close_level(JsonStream *js, bool array){
+    if (js->depth == 0 || js->level[js->depth - 1].array != array) {
+        return false;
+    }
+    text_reset(js);
+    emit(js, JSON_END);
+    js->depth--;
+    value_done(js);
+    return true;
+}
+
+static bool step(JsonStream *js, char c){
+    switch (js->state) {
+    case ST_STRING:
+        if (c == '"') {
+            return string_end(js);
+        }
+        if (c == '\\') {
+            js->state = ST_ESCAPE;
+        } else if ((unsigned char)c < 0x20) {
+            return false;
+        } else {
+            text_append(js, c);
+        }
+        return true;
+
+    case ST_ESCAPE: {
+        static const char from[] = "\"\\/bfnrt", to[] = "\"\\/\b\f\n\r\t";
+        const char *p = c ? strchr(from, c) : NULL;
+        js->state = ST_STRING;
+        if (c == 'u') {
+            js->unicode_left = 4;
+            js->state = ST_UNICODE;
+            return true;
+        }
+        if (!p) {
+            return false;
+        }
+        text_append(js, to[p - from]);
+        return true;
+    }
+
+    case ST_UNICODE:
+        // Só é usado para nomes; fora do ASCII vira '?'
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))) {
+            return false;
+        }
+        if (--js->unicode_left == 0) {
+            text_append(js, '?');
+            js->state = ST_STRING;
+        }
+        return true;
+
+    case ST_LITERAL:
+        if (is_literal_char(c)) {
+            text_append(js, c);
+            return true;
+        }
+        // O caractere que encerra o literal ainda precisa ser tratado
+        return literal_end(js) && step(js, c);
+
+    default:
+        break;
+    }
+
+    if (is_space(c)) {
+        return true;
+    }
+
+    switch (js->state) {
+    case ST_VALUE:
+        return value_start(js, c);
+    case ST_ARRAY_FIRST:
+        return c == ']' ? close_level(js, true) : value_start(js, c);
+    case ST_OBJECT_FIRST:
+        return c == '}' ? close_level(js, false) : key_start(js, c);
+    case ST_KEY:
+        return key_start(js, c);
+    case ST_COLON:
+        if (c != ':') {
+            return false;
+        }
+        js->state = ST_VALUE;
+        return true;
+    case ST_AFTER: {
+        JsonLevel *top = &js->level[js->depth - 1];
+        if (c == ',') {
+            if (top->array) {
+                top->index++;
+                js->state = ST_VALUE;
+            } else {
+                js->state = ST_KEY;
+            }
+            return true;
+        }
+        if (c != ']' && c != '}') {
+            return false;
+        }
+        return close_level(js, c == ']');
+    }
+    default:
+        return false; // Depois do fim do documento, ou já com erro
+    }
+}
+
+// Lê mais um pedaço do documento. Retorna false no primeiro erro de sintaxe.
+bool json_stream_feed(JsonStream *js, const char *data, size_t len){
+    for (size_t i = 0; i < len && js->state != ST_ERROR; i++, js->bytes++) {
+        if (!step(js, data[i])) {
+            js->state = ST_ERROR;
+        }
+    }
+    return js->state != ST_ERROR;
+}
+
+// Fim do corpo: o documento precisa estar completo
+bool json_stream_finish(JsonStream *js){
+    if (js->state == ST_LITERAL && js->depth == 0 && !literal_end(js)) {
+        js->state = ST_ERROR;
+    }
+    return js->state == ST_DONE;
+}
@@ -0,0 +1,54 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSON_STREAM_DEPTH 8         // Objetos/listas aninhados
+#define JSON_STREAM_KEY_MAX 24      // Chaves maiores são truncadas (e não casam com nenhuma conhecida)
+#define JSON_STREAM_VALUE_MAX 48    // Valores escalares maiores são truncados
+
+typedef enum {
+    JSON_STRING,
+    JSON_NUMBER,
+    JSON_TRUE,
+    JSON_FALSE,
+    JSON_NULL,
+    JSON_END,       // Fim de um objeto ou lista; level[depth-1] é o nível que fecha
+} JsonValueType;
+
+// Onde o valor está no documento: uma posição por nível (chave no objeto ou índice na lista)
+typedef struct {
+    bool array;
+    uint32_t index;                 // Posição na lista
+    char key[JSON_STREAM_KEY_MAX];  // Chave no objeto
+} JsonLevel;
+
+typedef struct JsonStream JsonStream;
+
+// Chamada para cada valor escalar e no fim de cada objeto ou lista (JSON_END, texto vazio);
+// js->level[0..js->depth-1] é o caminho até ele
+typedef void (*json_value_cb)(const JsonStream *js, JsonValueType type, const char *text, void *ctx);
+
+// Leitor de JSON em pedaços de qualquer tamanho, com memória fixa: só guarda o caminho atual
+// e o valor em leitura. Listas e objetos de qualquer tamanho passam sem ocupar memória.
+struct JsonStream {
+    uint8_t state;
+    uint8_t depth;
+    JsonLevel level[JSON_STREAM_DEPTH];
+    bool in_key;                        // A string em leitura é uma chave
+    char text[JSON_STREAM_VALUE_MAX];   // Chave ou valor em leitura
+    uint8_t text_len;
+    uint8_t unicode_left;               // Dígitos restantes de um \uXXXX
+    bool truncated;                     // Algum valor passou de JSON_STREAM_VALUE_MAX
+    uint32_t bytes;                     // Bytes lidos (posição do erro, se houver)
+    json_value_cb callback;
+    void *ctx;
+};
+
+void json_stream_init(JsonStream *js, json_value_cb callback, void *ctx);
+bool json_stream_feed(JsonStream *js, const char *data, size_t len);
+bool json_stream_finish(JsonStream *js);
+
+#endif // JSON_STREAM_H
@@ -0,0 +1,334 @@
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include "sdkconfig.h"
+#include "lap_engine.h"
+#include "lap_events.h"
+
+#define EARTH_RADIUS 6371000.0          // Utilizado para a formula de Haversine
+
+#define GATE_HALF_WIDTH 10.0            // Meia largura, em metros, das linhas definidas por um ponto
+
+// Inicialização da struct
+LapState lap_state = {
+    .started = false,
+    .next_gate = 0,
+    .lap = 0,
+    .start_time = 0,
+    .last_checkpoint_time = 0,
+    .live_time = 0
+};
+
+LapResult lap_current = { 0 };
+LapResult lap_last = { 0 };
+
+// Pista padrão: linha de chegada e mais dois setores
+static TrackDef active_track = {
+    .gate_count = 3,
+    .gates = {
+        { .lat = -26.925389, .lon = -48.941590 },   // Linha de chegada
+        { .lat = -26.924442, .lon = -48.940674 },   // Setor 1
+        { .lat = -26.924355, .lon = -48.942377 },   // Setor 2
+    },
+};
+
+// Pista pedida por outra task (o portal), carregada pela task do motor entre dois fixes
+enum {
+    PENDING_IDLE,
+    PENDING_WRITING,        // A task que pediu está copiando a pista
+    PENDING_READY,          // Aguardando a task do motor
+};
+static TrackDef pending_track;
+static atomic_int pending_state = PENDING_IDLE;
+static atomic_uint tracks_requested = 0;
+static atomic_uint tracks_applied = 0;
+
+// Referencial leste/norte da pista (origem na linha de chegada), calculado na carga da pista
+static PlanarRef track_origin;
+
+// Linhas de cronometragem de cada checkpoint, no referencial da pista
+static Gate gates[TRACK_MAX_GATES];
+
+// Último fix recebido, já projetado, usado para detectar o cruzamento das linhas
+static bool has_prev_fix = false;
+static lap_real_t prev_east, prev_north;
+static int64_t prev_time_us;
+
+// Função utilizada para calcular a distancia entre duas coordenadas em metros. O motor usa o
+// plano local; esta é a referência do relatório de precisão (host_test/engine_accuracy.c).
+double haversine(double lat1, double lon1, double lat2, double lon2){
+    double dLat = (lat2 - lat1) * M_PI / 180.0;
+    double dLon = (lon2 - lon1) * M_PI / 180.0;
+
+    // Converte latitude para radianos
+    lat1 = lat1 * M_PI / 180.0;
+    lat2 = lat2 * M_PI / 180.0;
+
+    // Fórmula de haversine
+    double a = sin(dLat / 2) * sin(dLat / 2) +
+               sin(dLon / 2) * sin(dLon / 2) * cos(lat1) * cos(lat2);
+    double c = 2 * atan2(sqrt(a), sqrt(1 - a));
+
+    return EARTH_RADIUS * c;
+}
+
+// Monta a origem do plano tangente local e suas escalas; só roda na carga da pista
+PlanarRef planar_ref_init(double lat, double lon){
+    double scale = EARTH_RADIUS * M_PI / 180.0 * 1e-7; // Metros por 1e-7 grau de latitude
+    PlanarRef ref = {
+        .lat_e7 = (int32_t)lround(lat * 1e7),
+        .lon_e7 = (int32_t)lround(lon * 1e7),
+        .north_m = (lap_real_t)scale,
+        .east_m = (lap_real_t)(scale * cos(lat * M_PI / 180.0)),
+    };
+    return ref;
+}
+
+// Projeta uma posição em 1e-7 grau no plano da referência (metros a leste e ao norte)
+static inline void planar_project(const PlanarRef *ref, int32_t lat_e7, int32_t lon_e7,
+                                  lap_real_t *east, lap_real_t *north){
+    *north = (lap_real_t)(lat_e7 - ref->lat_e7) * ref->north_m;
+    *east = (lap_real_t)(lon_e7 - ref->lon_e7) * ref->east_m;
+}
+
+// Formata um tempo em microssegundos como "mm:ss,mmm". Só para quem mostra o tempo (log,
+// replay); o motor guarda apenas inteiros.
+void lap_format_time(char *buf, size_t len, int64_t time_us){
+    int64_t elapsed_time_ms = time_us / 1000;           // Tempo em milissegundos
+    int minutes = elapsed_time_ms / (60 * 1000);        // Minutos
+    int seconds = (elapsed_time_ms % (60 * 1000)) / 1000;   // Segundos
+    int milliseconds = elapsed_time_ms % 1000;          // Milissegundos
+    snprintf(buf, len, "%2d:%2d,%3d", minutes, seconds, milliseconds);
+}
+
+// Projeta uma coordenada em graus decimais no referencial da pista
+static void track_project(double lat, double lon, lap_real_t *east, lap_real_t *north){
+    planar_project(&track_origin, (int32_t)lround(lat * 1e7), (int32_t)lround(lon * 1e7), east, north);
+}
+
+// Monta a linha de um checkpoint. Se a pista traz as duas extremidades, usa o segmento como
+// está; senão centra a linha no ponto, perpendicular à corda entre o checkpoint anterior e
+// o próximo, que aproxima a direção da pista naquele ponto.
+static Gate gate_build(const TrackDef *track, int index){
+    const TrackGate *def = &track->gates[index];
+    const TrackGate *prev = &track->gates[(index + track->gate_count - 1) % track->gate_count];
+    const TrackGate *next = &track->gates[(index + 1) % track->gate_count];
+    Gate gate;
+    lap_real_t ce, cn, pe, pn, ne, nn;
+
+    track_project(def->lat, def->lon, &ce, &cn);
+
+    if (def->has_line) {
+        lap_real_t be, bn;
+        track_project(def->lat_b, def->lon_b, &be, &bn);
+        gate.a_east = ce;
+        gate.a_north = cn;
+        gate.ab_east = be - ce;
+        gate.ab_north = bn - cn;
+        return gate;
+    }
+
+    track_project(prev->lat, prev->lon, &pe, &pn);
+    track_project(next->lat, next->lon, &ne, &nn);
+
+    lap_real_t de = ne - pe;
+    lap_real_t dn = nn - pn;
+    lap_real_t norm = (lap_real_t)sqrt(de * de + dn * dn);
+    if (norm < (lap_real_t)1.0) {
+        // Pista com duas linhas: anterior e próxima coincidem, usa a direção até a próxima
+        de = ne - ce;
+        dn = nn - cn;
+        norm = (lap_real_t)sqrt(de * de + dn * dn);
+    }
+    if (norm < (lap_real_t)1.0) {
+        // Checkpoints sobrepostos: assume linha no sentido norte-sul
+        de = 1;
+        dn = 0;
+        norm = 1;
+    }
+
+    // Perpendicular à direção da pista, com GATE_HALF_WIDTH para cada lado do centro
+    lap_real_t half_east = -dn / norm * GATE_HALF_WIDTH;
+    lap_real_t half_north = de / norm * GATE_HALF_WIDTH;
+    gate.a_east = ce - half_east;
+    gate.a_north = cn - half_north;
+    gate.ab_east = 2 * half_east;
+    gate.ab_north = 2 * half_north;
+    return gate;
+}
+
+// Pista atualmente carregada no motor
+const TrackDef *lap_engine_track(void){
+    return &active_track;
+}
+
+// Carrega uma nova pista: recalcula o referencial e as linhas e reinicia a volta em andamento
+void lap_engine_load_track(const TrackDef *track){
+    if (track != &active_track) {
+        active_track = *track;
+    }
+    if (active_track.gate_count > TRACK_MAX_GATES) {
+        active_track.gate_count = TRACK_MAX_GATES;
+    }
+    if (active_track.gate_count == 0) {
+        active_track.gate_count = 1; // Pista vazia: só a linha de chegada
+    }
+
+    track_origin = planar_ref_init(active_track.gates[0].lat, active_track.gates[0].lon);
+    for (int i = 0; i < active_track.gate_count; i++) {
+        gates[i] = gate_build(&active_track, i);
+    }
+
+    lap_state.started = false;
+    lap_state.next_gate = 0;
+    lap_state.lap = 0;
+    lap_current = (LapResult){ 0 };
+    has_prev_fix = false;
+}
+
+// Pede a troca de pista a partir de outra task. lap_engine_load_track mexe nas linhas e na volta
+// em andamento, então só a task que chama process_position pode aplicá-la (lap_engine_apply_pending).
+// Retorna o número do pedido, aplicado quando lap_engine_tracks_applied() o alcançar, ou 0 se
+// ainda há um pedido anterior pendente.
+uint32_t lap_engine_request_track(const TrackDef *track){
+    int expected = PENDING_IDLE;
+    if (!atomic_compare_exchange_strong(&pending_state, &expected, PENDING_WRITING)) {
+        return 0;
+    }
+    pending_track = *track;
+    uint32_t ticket = atomic_fetch_add(&tracks_requested, 1) + 1;
+    atomic_store(&pending_state, PENDING_READY);
+    return ticket;
+}
+
+// Pedidos de troca de pista já aplicados
+uint32_t lap_engine_tracks_applied(void){
+    return atomic_load(&tracks_applied);
+}
+
+// Na task do motor, fora de process_position: carrega a pista pedida, se houver
+bool lap_engine_apply_pending(void){
+    if (atomic_load(&pending_state) != PENDING_READY) {
+        return false;
+    }
+    lap_engine_load_track(&pending_track);
+    atomic_fetch_add(&tracks_applied, 1);
+    atomic_store(&pending_state, PENDING_IDLE);
+    return true;
+}
+
+// Verifica se o trajeto P0->P1 (já projetado) cruza a linha do checkpoint. Em caso positivo,
+// devolve o instante do cruzamento interpolado entre os dois fixes. Só multiplicações e somas,
+// a divisão acontece apenas quando há cruzamento.
+static bool gate_crossed(const Gate *gate, lap_real_t east, lap_real_t north, int64_t now_us, int64_t *cross_us){
+    // Interseção dos segmentos P0->P1 (trajeto) e A->B (linha)
+    lap_real_t de = east - prev_east, dn = north - prev_north;
+    lap_real_t denom = de * gate->ab_north - dn * gate->ab_east;
+    if (denom == 0) {
+        return false; // Trajeto paralelo à linha (ou parado)
+    }
+
+    lap_real_t ae = gate->a_east - prev_east, an = gate->a_north - prev_north;
+    lap_real_t t_num = ae * gate->ab_north - an * gate->ab_east;  // Fração percorrida entre P0 e P1
+    lap_real_t u_num = ae * dn - an * de;                         // Posição ao longo da linha
+    if (denom < 0) {
+        denom = -denom;
+        t_num = -t_num;
+        u_num = -u_num;
+    }
+    if (t_num <= 0 || t_num > denom || u_num < 0 || u_num > denom) {
+        return false;
+    }
+
+    *cross_us = prev_time_us + (int64_t)(t_num / denom * (lap_real_t)(now_us - prev_time_us));
+    return true;
+}
+
+// Publica um evento da cronometragem para os consumidores (portal, log)
+static void emit(LapEventType type, uint8_t sector, int64_t time_us, int64_t duration_us){
+    LapEvent event = {
+        .type = type,
+        .sector = sector,
+        .lap = lap_state.lap,
+        .time_us = time_us,
+        .duration_us = duration_us,
+    };
+    lap_events_publish(&event);
+}
+
+// Começa uma nova volta na passagem pela chegada
+static void lap_begin(int64_t cross_us){
+    lap_state.lap++;
+    lap_state.start_time = cross_us;
+    lap_state.last_checkpoint_time = cross_us;
+    lap_current = (LapResult){ 0 };
+    emit(LAP_EVENT_LAP_START, 0, cross_us, 0);
+}
+
+// Registra a passagem pela linha esperada: fecha o setor e, na chegada, a volta
+static void gate_passed(int64_t cross_us){
+    if (!lap_state.started) {
+        // Inicia o contador
+        lap_state.started = true;
+        lap_begin(cross_us);
+    } else {
+        // Tempo do setor que termina nesta linha
+        int64_t sector_us = cross_us - lap_state.last_checkpoint_time;
+        lap_current.sector_us[lap_current.sector_count++] = sector_us;
+        lap_state.last_checkpoint_time = cross_us; // Atualiza o último checkpoint
+        emit(LAP_EVENT_SECTOR, lap_current.sector_count, cross_us, sector_us);
+
+        if (lap_state.next_gate == 0) {
+            // Finaliza a volta; a mesma passagem pela linha já inicia a próxima
+            lap_current.lap_us = cross_us - lap_state.start_time;
+            lap_last = lap_current;
+            emit(LAP_EVENT_LAP_COMPLETE, lap_current.sector_count, cross_us, lap_current.lap_us);
+
+            lap_begin(cross_us);
+        }
+    }
+
+    lap_state.next_gate = (lap_state.next_gate + 1) % active_track.gate_count;
+}
+
+// Chegada cruzada antes de passar por todos os setores (corte de pista ou checkpoint perdido):
+// descarta a volta e começa outra nesta passagem
+static void lap_invalid(int64_t cross_us){
+    emit(LAP_EVENT_LAP_INVALID, lap_current.sector_count, cross_us, cross_us - lap_state.start_time);
+    lap_begin(cross_us);
+    lap_state.next_gate = 1 % active_track.gate_count;
+}
+
+// Compara o trajeto desde o último fix (posição em 1e-7 grau) com a linha do próximo checkpoint.
+// Por fix: uma projeção e um teste de cruzamento (dois no meio da volta, para notar a chegada
+// fora da sequência), independente da quantidade de checkpoints.
+// now_us é o instante da medição em qualquer relógio contínuo (horário GNSS ou esp_timer).
+void process_position(int32_t lat_e7, int32_t lon_e7, int64_t now_us){
+    int64_t cross_us = 0;               // Instante interpolado do cruzamento
+    lap_real_t east, north;             // Posição no referencial da pista
+
+    if (has_prev_fix && now_us <= prev_time_us) {
+        return; // Fix repetido ou fora de ordem
+    }
+
+    if(lap_state.started){
+        lap_state.live_time = now_us;
+    }
+
+    planar_project(&track_origin, lat_e7, lon_e7, &east, &north);
+
+    // O primeiro fix só serve de ponto de partida para o próximo segmento
+    if (has_prev_fix) {
+        if (gate_crossed(&gates[lap_state.next_gate], east, north, now_us, &cross_us)) {
+            gate_passed(cross_us);
+        } else if (lap_state.started && lap_state.next_gate != 0 &&
+                   gate_crossed(&gates[0], east, north, now_us, &cross_us)) {
+            lap_invalid(cross_us);
+        }
+    }
+
+    has_prev_fix = true;
+    prev_east = east;
+    prev_north = north;
+    prev_time_us = now_us;
+}
@@ -0,0 +1,77 @@
+#ifndef LAP_ENGINE_H
+#define LAP_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#define TRACK_MAX_GATES 32      // Máximo de linhas (e de setores) por pista
+
+// Linha de um checkpoint na definição da pista. gates[0] é a linha de chegada.
+typedef struct {
+    double lat, lon;        // Centro da linha (ou extremidade A, se has_line)
+    double lat_b, lon_b;    // Extremidade B, usada só quando has_line
+    bool has_line;          // false: linha perpendicular à pista, centrada em lat/lon
+} TrackGate;
+
+// Definição da pista: cada linha fecha um setor, a última volta para a chegada
+typedef struct {
+    uint8_t gate_count;
+    TrackGate gates[TRACK_MAX_GATES];
+} TrackDef;
+
+typedef struct {
+    bool started;                   // Se o contador foi iniciado
+    uint8_t next_gate;              // Próxima linha esperada na sequência da volta
+    uint16_t lap;                   // Volta em andamento (1 = primeira volta cronometrada)
+    int64_t start_time;             // Tempo de início em microssegundos
+    int64_t last_checkpoint_time;   // Tempo do último checkpoint
+    int64_t live_time;              // Tempo ao vivo
+} LapState;
+
+// Resultado de uma volta: tempo total e de cada setor, em microssegundos
+typedef struct {
+    uint8_t sector_count;                   // Setores já concluídos
+    int64_t lap_us;                         // Tempo da volta (0 enquanto em andamento)
+    int64_t sector_us[TRACK_MAX_GATES];
+} LapResult;
+
+// Precisão da geometria no plano local, escolhida no menuconfig
+#if CONFIG_LAP_TIMER_ENGINE_DOUBLE
+typedef double lap_real_t;
+#else
+typedef float lap_real_t;
+#endif
+
+// Ponto de referência do plano tangente local (leste/norte em metros)
+typedef struct {
+    int32_t lat_e7;         // Origem em 1e-7 grau
+    int32_t lon_e7;
+    lap_real_t north_m;     // Metros por 1e-7 grau de latitude
+    lap_real_t east_m;      // Metros por 1e-7 grau de longitude (escala cos(lat0))
+} PlanarRef;
+
+// Linha de cronometragem: segmento A-B no referencial leste/norte da pista
+typedef struct {
+    lap_real_t a_east, a_north;     // Extremidade A em metros a partir da origem da pista
+    lap_real_t ab_east, ab_north;   // Vetor de A até B
+} Gate;
+
+extern LapState lap_state;
+extern LapResult lap_current;   // Setores da volta em andamento
+extern LapResult lap_last;      // Última volta completa
+
+double haversine(double lat1, double lon1, double lat2, double lon2);
+PlanarRef planar_ref_init(double lat, double lon);
+
+void lap_format_time(char *buf, size_t len, int64_t time_us);
+
+const TrackDef *lap_engine_track(void);
+void lap_engine_load_track(const TrackDef *track);
+uint32_t lap_engine_request_track(const TrackDef *track);
+uint32_t lap_engine_tracks_applied(void);
+bool lap_engine_apply_pending(void);
+void process_position(int32_t lat_e7, int32_t lon_e7, int64_t now_us);
+
+#endif // LAP_ENGINE_H
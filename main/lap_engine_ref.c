@@ -0,0 +1,31 @@
+// Motor de voltas compilado de novo em double, com os símbolos prefixados com ref_ (ver
+// lap_engine_ref.h). Não publica eventos: só o motor de verdade fala com o portal e o log.
+#include "sdkconfig.h"
+
+#if CONFIG_LAP_TIMER_ENGINE_BENCHMARK
+
+#undef CONFIG_LAP_TIMER_ENGINE_PLANAR
+#undef CONFIG_LAP_TIMER_ENGINE_DOUBLE
+#define CONFIG_LAP_TIMER_ENGINE_DOUBLE 1
+
+#define lap_state ref_lap_state
+#define lap_current ref_lap_current
+#define lap_last ref_lap_last
+#define haversine ref_haversine
+#define planar_ref_init ref_planar_ref_init
+#define lap_format_time ref_lap_format_time
+#define lap_engine_track ref_lap_engine_track
+#define lap_engine_load_track ref_lap_engine_load_track
+#define lap_engine_request_track ref_lap_engine_request_track
+#define lap_engine_tracks_applied ref_lap_engine_tracks_applied
+#define lap_engine_apply_pending ref_lap_engine_apply_pending
+#define process_position ref_process_position
+#define lap_events_publish ref_lap_events_publish
+
+#include "lap_engine.c"
+
+void ref_lap_events_publish(LapEvent *event){
+    (void)event;
+}
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef LAP_ENGINE_REF_H
+#define LAP_ENGINE_REF_H
+
+#include <stdint.h>
+#include "lap_engine.h"
+
+// Segunda cópia do motor de voltas, sempre em double (lap_engine_ref.c), para comparar a versão
+// escolhida no menuconfig com ela: mesmos fixes, tempos de cruzamento e custo por fix.
+// Só existe com CONFIG_LAP_TIMER_ENGINE_BENCHMARK.
+extern LapState ref_lap_state;
+
+void ref_lap_engine_load_track(const TrackDef *track);
+void ref_process_position(int32_t lat_e7, int32_t lon_e7, int64_t now_us);
+
+#endif // LAP_ENGINE_REF_H
@@ -0,0 +1,87 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "lap_events.h"
+
+#define RING_MASK (LAP_EVENT_RING_SIZE - 1)
+
+_Static_assert((LAP_EVENT_RING_SIZE & RING_MASK) == 0, "LAP_EVENT_RING_SIZE precisa ser potência de 2");
+
+// Anel de eventos com um escritor (a task da UART) e qualquer número de leitores. Cada posição
+// é um seqlock: seq é zerado enquanto o escritor copia o evento e recebe o número do evento no
+// fim. O escritor nunca espera; um leitor que encontra a posição já reescrita conta a perda.
+typedef struct {
+    atomic_uint seq;
+    LapEvent event;
+} LapEventSlot;
+
+static LapEventSlot ring[LAP_EVENT_RING_SIZE];
+static atomic_uint events_head;    // seq do último evento publicado (0 = nenhum)
+
+// Publica um evento e preenche seu seq; só pode ser chamada de uma task
+void lap_events_publish(LapEvent *event){
+    unsigned seq = atomic_load_explicit(&events_head, memory_order_relaxed) + 1;
+    LapEventSlot *slot = &ring[seq & RING_MASK];
+
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    event->seq = seq;
+    memcpy(&slot->event, event, sizeof(slot->event));
+
+    atomic_store_explicit(&slot->seq, seq, memory_order_release);
+    atomic_store_explicit(&events_head, seq, memory_order_release);
+}
+
+// Começa a ler a partir do próximo evento publicado
+void lap_events_reader_init(LapEventReader *reader){
+    reader->next = atomic_load_explicit(&events_head, memory_order_acquire) + 1;
+    reader->dropped = 0;
+}
+
+// Copia o próximo evento do leitor. Retorna false se ele já leu tudo; nunca bloqueia o escritor.
+bool lap_events_read(LapEventReader *reader, LapEvent *out){
+    for (;;) {
+        uint32_t head = atomic_load_explicit(&events_head, memory_order_acquire);
+        if ((int32_t)(head - reader->next) < 0) {
+            return false;
+        }
+
+        // Ficou para trás mais que o anel: pula para o mais antigo que ainda existe
+        if (head - reader->next >= LAP_EVENT_RING_SIZE) {
+            uint32_t lost = head - LAP_EVENT_RING_SIZE + 1 - reader->next;
+            reader->dropped += lost;
+            reader->next += lost;
+        }
+
+        LapEventSlot *slot = &ring[reader->next & RING_MASK];
+        unsigned before = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        memcpy(out, &slot->event, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        unsigned after = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+        if (before == reader->next && after == before) {
+            reader->next++;
+            return true;
+        }
+        // O escritor já está reescrevendo esta posição com um evento mais novo: este se perdeu
+        reader->dropped++;
+        reader->next++;
+    }
+}
+
+// seq do último evento publicado, para saber se há novidade sem ler
+uint32_t lap_events_head(void){
+    return atomic_load_explicit(&events_head, memory_order_acquire);
+}
+
+// Nome do tipo de evento, como aparece no portal
+const char *lap_event_name(uint8_t type){
+    switch (type) {
+    case LAP_EVENT_LAP_START: return "inicio";
+    case LAP_EVENT_SECTOR: return "setor";
+    case LAP_EVENT_LAP_COMPLETE: return "completa";
+    case LAP_EVENT_LAP_INVALID: return "invalida";
+    case LAP_EVENT_FIX_LOST: return "sem_sinal";
+    default: return "?";
+    }
+}
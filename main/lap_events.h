@@ -0,0 +1,42 @@
+#ifndef LAP_EVENTS_H
+#define LAP_EVENTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LAP_EVENT_RING_SIZE 64      // Eventos guardados para os leitores (potência de 2)
+
+typedef enum {
+    LAP_EVENT_LAP_START = 1,        // Passou pela chegada e uma volta começou
+    LAP_EVENT_SECTOR,               // Setor concluído (também o último, antes do LAP_COMPLETE)
+    LAP_EVENT_LAP_COMPLETE,         // Volta fechada com todos os setores
+    LAP_EVENT_LAP_INVALID,          // Chegada cruzada fora da sequência: volta descartada
+    LAP_EVENT_FIX_LOST,             // O receptor deixou de ter posição
+} LapEventType;
+
+// Um evento da cronometragem. Os tempos estão no relógio da cronometragem (horário GNSS ou
+// esp_timer, conforme o menuconfig), em microssegundos.
+typedef struct {
+    uint32_t seq;           // Número do evento, preenchido pelo anel (começa em 1)
+    uint8_t type;           // LapEventType
+    uint8_t sector;         // Setor concluído (1 = primeiro); na volta inválida, setores feitos
+    uint16_t lap;           // Volta a que o evento pertence (1 = primeira volta cronometrada)
+    int64_t time_us;        // Instante do cruzamento (ou do fix)
+    int64_t duration_us;    // Tempo do setor ou da volta; 0 nos demais eventos
+} LapEvent;
+
+// Posição de um leitor no anel. Cada consumidor (portal, log, display) tem o seu e lê no
+// próprio ritmo; se ficar para trás mais que o anel, os eventos mais antigos são contados
+// em dropped e ele continua do mais antigo ainda disponível.
+typedef struct {
+    uint32_t next;          // seq do próximo evento a ler
+    uint32_t dropped;       // Eventos perdidos por este leitor
+} LapEventReader;
+
+void lap_events_publish(LapEvent *event);
+void lap_events_reader_init(LapEventReader *reader);
+bool lap_events_read(LapEventReader *reader, LapEvent *out);
+uint32_t lap_events_head(void);
+const char *lap_event_name(uint8_t type);
+
+#endif // LAP_EVENTS_H
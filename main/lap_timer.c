@@ -1,161 +1,61 @@
-#include <stdio.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "driver/uart.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "string.h"
 #include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_attr.h"
+#include "esp_intr_alloc.h"
 #include "wifi.h"
+#include "line_assembler.h"
+#include "gnss_pipeline.h"
+#include "gnss_config.h"
+#include "telemetry.h"
+#include "lap_events.h"
+#include "lap_engine.h"
+#include "lap_engine_ref.h"
 #include "nvs_flash.h"
 
-#define EARTH_RADIUS 6371000.0          // Utilizado para a formula de Haversine
-
-#define TOLERANCE 10.0                  // Tolerância em metros para computar a passagem por um checkpoint
-
 static const int RX_BUF_SIZE = 1024;    // Utilizado para o buffer do pino RX da porta UART
 
 #define TXD_PIN (GPIO_NUM_17)           // Pino 17 da ESP definido como TX
 #define RXD_PIN (GPIO_NUM_16)           // Pino 16 da ESP definido como RX
 
-// Coordenadas da linha de chegada e setor 3
-double lat_start = -26.925389;
-double lon_start = -48.941590;
-// Coordenadas da linha do setor 1
-double lat_sec1 = -26.924442;
-double lon_sec1 = -48.940674;
-// Coordenadas da linha do setor 2
-double lat_sec2 = -26.924355;
-double lon_sec2 = -48.942377;
-
-float velocidade = 0.0;
-char volta_atual[20] = "Sem Dados ";    // Volta sendo observada
-char volta_anterior[20] = "Sem Dados "; // Volta anterior
-char tempo_set1[20] = "Sem Dados ";
-char tempo_set2[20] = "Sem Dados ";
-char tempo_set3[20] = "Sem Dados ";
-
-typedef struct {
-    bool started;                   // Se o contador foi iniciado
-    bool checkpoint_1;              // Se passou pelo ponto Y
-    bool checkpoint_2;              // Se passou pelo ponto Z
-    int64_t start_time;             // Tempo de início em microssegundos
-    int64_t last_checkpoint_time;   // Tempo do último checkpoint
-    int64_t live_time;              // Tempo ao vivo
-} LapState;
-
-// Inicialização da struct
-LapState lap_state = {
-    .started = false, 
-    .checkpoint_1 = false, 
-    .checkpoint_2 = false, 
-    .start_time = 0,
-    .last_checkpoint_time = 0,
-    .live_time = 0
-};
-
-// Função utilizada para calcular a distancia entre duas coordenadas em metros
-double haversine(double lat1, double lon1, double lat2, double lon2){
-    double dLat = (lat2 - lat1) * M_PI / 180.0;
-    double dLon = (lon2 - lon1) * M_PI / 180.0;
-
-    // Converte latitude para radianos
-    lat1 = lat1 * M_PI / 180.0;
-    lat2 = lat2 * M_PI / 180.0;
-
-    // Fórmula de haversine
-    double a = sin(dLat / 2) * sin(dLat / 2) +
-               sin(dLon / 2) * sin(dLon / 2) * cos(lat1) * cos(lat2);
-    double c = 2 * atan2(sqrt(a), sqrt(1 - a));
-
-    return EARTH_RADIUS * c;
-}
-
-// Compara a localização atual com os checkpoints para encontrar os tempos
-void process_position(double lat, double lon){
-    // Verifica se está próximo à linha de chegada
-    int64_t elapsed_time_ms = 0;        // Tempo em milissegundos
-    int minutes = 0;                    // Minutos
-    int seconds = 0;                    // Segundos
-    int milliseconds = 0;               // Milissegundos
-
-    if(lap_state.started){
-        lap_state.live_time = esp_timer_get_time();
-        elapsed_time_ms = (lap_state.live_time - lap_state.last_checkpoint_time) / 1000; // Tempo em milissegundos
-        minutes = elapsed_time_ms / (60 * 1000);             // Minutos
-        seconds = (elapsed_time_ms % (60 * 1000)) / 1000;    // Segundos
-        milliseconds = elapsed_time_ms % 1000;              // Milissegundos
-        sprintf(volta_atual, "%2d:%2d,%3d", minutes, seconds, milliseconds); // Salva os tempos em um char
-    }
+#define UART_QUEUE_SIZE 20              // Eventos pendentes na fila do driver da UART
 
-    if (haversine(lat, lon, lat_start, lon_start) < TOLERANCE) {
-        if (!lap_state.started) {
-            // Inicia o contador
-            lap_state.started = true;
-            lap_state.start_time = esp_timer_get_time();
-            lap_state.last_checkpoint_time = lap_state.start_time;
-
-        } else if (lap_state.checkpoint_1 && lap_state.checkpoint_2) {
-            // Finaliza a volta
-            int64_t end_time = esp_timer_get_time();
-
-            // Tempo do setor 3 (entre o setor 2 e a finalização)
-            elapsed_time_ms = (end_time - lap_state.last_checkpoint_time) / 1000; // Tempo em milissegundos
-            minutes = elapsed_time_ms / (60 * 1000);             // Minutos
-            seconds = (elapsed_time_ms % (60 * 1000)) / 1000;    // Segundos
-            milliseconds = elapsed_time_ms % 1000;              // Milissegundos
-            sprintf(tempo_set3, "%2d:%2d,%3d", minutes, seconds, milliseconds); // Salva os tempos em um char
-
-            // Tempo total
-            elapsed_time_ms = (end_time - lap_state.start_time) / 1000; // Tempo em milissegundos
-            minutes = elapsed_time_ms / (60 * 1000);             // Minutos
-            seconds = (elapsed_time_ms % (60 * 1000)) / 1000;    // Segundos
-            milliseconds = elapsed_time_ms % 1000;              // Milissegundos
-            sprintf(volta_anterior, "%2d:%2d,%3d", minutes, seconds, milliseconds); // Salva os tempos em um char
-
-            // Reseta o estado
-            lap_state.started = false;
-            lap_state.checkpoint_1 = false;
-            lap_state.checkpoint_2 = false;
-            lap_state.start_time = 0;
-            lap_state.last_checkpoint_time = 0;
-        }
-    }
+static QueueHandle_t uart_queue;        // Fila de eventos do driver da UART
 
-    if (lap_state.started){
-        if (!lap_state.checkpoint_1 && haversine(lat, lon, lat_sec1, lon_sec1) < TOLERANCE) {
-        int64_t sec1_time = esp_timer_get_time();
+#define PPS_QUEUE_SIZE 4                // Bordas de PPS aguardando o próximo fix
 
-        // Tempo entre início e setor 1
-        elapsed_time_ms = (sec1_time - lap_state.last_checkpoint_time) / 1000; // Tempo em milissegundos
-        minutes = elapsed_time_ms / (60 * 1000);             // Minutos
-        seconds = (elapsed_time_ms % (60 * 1000)) / 1000;    // Segundos
-        milliseconds = elapsed_time_ms % 1000;              // Milissegundos
-        sprintf(tempo_set1, "%2d:%2d,%3d", minutes, seconds, milliseconds); // Salva os tempos em um char
+#define TRACK_POLL_MS 100               // Sem dados do receptor, a task ainda acorda para trocar a pista
 
-        lap_state.checkpoint_1 = true;
-        lap_state.last_checkpoint_time = sec1_time; // Atualiza o último checkpoint
-    }
+// Mensagens do receptor até o motor de voltas: épocas NMEA ou NAV-PVT, base de tempo e relógio
+static GnssPipeline gnss;
+static QueueHandle_t pps_queue;         // Bordas de PPS lidas na ISR
 
-        // Verifica se passou pelo Setor 2
-        if (lap_state.checkpoint_1 && !lap_state.checkpoint_2 && haversine(lat, lon, lat_sec2, lon_sec2) < TOLERANCE) {
-            int64_t sec2_time = esp_timer_get_time();
+// Histogramas de latência. Cada posição conta as amostras abaixo do limite correspondente;
+// a última, as demais.
+static const int64_t LATENCY_LIMIT_US[] = { 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000 };
+#define LATENCY_BUCKETS (sizeof(LATENCY_LIMIT_US) / sizeof(LATENCY_LIMIT_US[0]) + 1)
+#define LATENCY_LOG_INTERVAL 600        // Amostras entre dois logs do histograma (1 min a 10 Hz)
 
-            // Tempo entre setor 1 e setor 2
-            elapsed_time_ms = (sec2_time - lap_state.last_checkpoint_time) / 1000; // Tempo em milissegundos
-            minutes = elapsed_time_ms / (60 * 1000);             // Minutos
-            seconds = (elapsed_time_ms % (60 * 1000)) / 1000;    // Segundos
-            milliseconds = elapsed_time_ms % 1000;              // Milissegundos
-            sprintf(tempo_set2, "%2d:%2d,%3d", minutes, seconds, milliseconds); // Salva os tempos em um char
-            
+typedef struct {
+    const char *label;
+    uint32_t hist[LATENCY_BUCKETS];
+    uint32_t samples;
+} LatencyHist;
 
-            lap_state.checkpoint_2 = true;
-            lap_state.last_checkpoint_time = sec2_time; // Atualiza o último checkpoint
-        }
-    }
-}
+// Chegada na UART da sentença (ou quadro) que completou a época até o fim de process_position
+static LatencyHist uart_latency = { .label = "UART -> process_position" };
+// Instante estimado da medição até o fim de process_position; inclui o atraso de saída do receptor
+static LatencyHist epoch_latency = { .label = "medicao -> process_position" };
 
 // Inicialização da porta UART
 void init_uart(void){
@@ -169,7 +69,7 @@ void init_uart(void){
     };
 
     // Instala o driver da UART com buffer de recepção
-    esp_err_t ret = uart_driver_install(UART_NUM_2, RX_BUF_SIZE * 2, RX_BUF_SIZE * 2, 10, NULL, 0);
+    esp_err_t ret = uart_driver_install(UART_NUM_2, RX_BUF_SIZE * 2, RX_BUF_SIZE * 2, UART_QUEUE_SIZE, &uart_queue, 0);
     if (ret != ESP_OK) {
         ESP_LOGE("UART", "Failed to install UART driver: %s", esp_err_to_name(ret));
         return;
@@ -186,168 +86,478 @@ void init_uart(void){
     ret = uart_set_pin(UART_NUM_2, TXD_PIN, RXD_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
     if (ret != ESP_OK) {
         ESP_LOGE("UART", "Failed to set UART pins: %s", esp_err_to_name(ret));
+        return;
     }
+
+#if CONFIG_LAP_TIMER_GNSS_NMEA
+    // Gera um evento UART_PATTERN_DET a cada '\n', acordando a task assim que a sentença termina
+    uart_enable_pattern_det_baud_intr(UART_NUM_2, '\n', 1, 9, 0, 0);
+    uart_pattern_queue_reset(UART_NUM_2, UART_QUEUE_SIZE);
+#endif
 }
 
-// Função corrigida para converter coordenadas NMEA para decimal
-double nmea_to_decimal(const char *coord, char direction){
-    double degrees = 0.0;
-    double minutes = 0.0;
-
-    // Verifica o formato: latitude tem 2 dígitos para graus, longitude tem 3 dígitos
-    if (strlen(coord) > 7) {
-        if (coord[4] == '.') { // Exemplo: 2655.48542 (latitude)
-            sscanf(coord, "%2lf%lf", &degrees, &minutes); // 2 dígitos para latitude
-        } else { // Exemplo: 04856.61815 (longitude)
-            sscanf(coord, "%3lf%lf", &degrees, &minutes); // 3 dígitos para longitude
-        }
+#if CONFIG_LAP_TIMER_PPS_GPIO >= 0
+// Borda de subida do PPS: só lê o esp_timer e entrega o valor para a task da UART
+static void IRAM_ATTR pps_isr(void *arg){
+    int64_t edge_us = esp_timer_get_time();
+    BaseType_t woken = pdFALSE;
+    xQueueSendFromISR(pps_queue, &edge_us, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// Configura a entrada do PPS com interrupção na borda de subida. O pino precisa do pulldown
+// interno (os só de entrada, 34 a 39, não têm) e não pode ser um dos pinos da UART do receptor.
+static void init_pps(void){
+    if (!GPIO_IS_VALID_OUTPUT_GPIO(CONFIG_LAP_TIMER_PPS_GPIO) || CONFIG_LAP_TIMER_PPS_GPIO == TXD_PIN ||
+        CONFIG_LAP_TIMER_PPS_GPIO == RXD_PIN) {
+        ESP_LOGE("PPS", "GPIO %d cannot be used for PPS (input-only or GNSS UART pin)", CONFIG_LAP_TIMER_PPS_GPIO);
+        return;
     }
 
-    // Converte para decimal
-    double decimal = degrees + (minutes / 60.0);
+    pps_queue = xQueueCreate(PPS_QUEUE_SIZE, sizeof(int64_t));
+    if (!pps_queue) {
+        ESP_LOGE("PPS", "Failed to create PPS queue");
+        return;
+    }
 
-    // Aplica sinal baseado na direção
-    if (direction == 'S' || direction == 'W') {
-        decimal = -decimal;
+    const gpio_config_t pps_config = {
+        .pin_bit_mask = 1ULL << CONFIG_LAP_TIMER_PPS_GPIO,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_POSEDGE,
+    };
+    esp_err_t ret = gpio_config(&pps_config);
+    if (ret == ESP_OK) {
+        ret = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    }
+    if (ret == ESP_OK) {
+        ret = gpio_isr_handler_add(CONFIG_LAP_TIMER_PPS_GPIO, pps_isr, NULL);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE("PPS", "Failed to set up PPS input: %s", esp_err_to_name(ret));
+    }
+}
+#endif
+
+#if CONFIG_LAP_TIMER_GNSS_AUTOCONFIG
+// Leva o receptor ao baud rate e à taxa de navegação do menuconfig. A procura lê a UART
+// diretamente, então os eventos e posições de '\n' acumulados nesse meio tempo são descartados.
+static void configure_receiver(void){
+    if (!uart_queue) {
+        return;
     }
 
-    return decimal;
+#if CONFIG_LAP_TIMER_GNSS_UBX
+    const bool ubx_output = true;
+#else
+    const bool ubx_output = false;
+#endif
+    gnss_config_run(UART_NUM_2, CONFIG_LAP_TIMER_GNSS_BAUD, CONFIG_LAP_TIMER_GNSS_RATE_HZ, ubx_output);
+
+    uart_flush_input(UART_NUM_2);
+    xQueueReset(uart_queue);
+#if CONFIG_LAP_TIMER_GNSS_NMEA
+    uart_pattern_queue_reset(UART_NUM_2, UART_QUEUE_SIZE);
+#endif
 }
+#endif
 
-// Função para processar mensagens NMEA e extrair dados do $GNRMC
-void process_nmea_line(const char *line){
-    // Verifica se a linha começa com $GNRMC
-    if (strncmp(line, "$GNRMC", 6) == 0) {
-        // Tokens da linha separados por vírgulas
-        char tokens[20][20];
-        int token_count = 0;
-        const char *ptr = line;
-
-        // Divide a linha em tokens separados por vírgulas
-        while (*ptr) {
-            char *comma = strchr(ptr, ',');
-            if (comma == NULL) {
-                strcpy(tokens[token_count++], ptr);
-                break;
+// Registra uma amostra de latência e, periodicamente, mostra o histograma no log
+static void latency_record(LatencyHist *h, int64_t latency_us){
+    size_t bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && latency_us >= LATENCY_LIMIT_US[bucket]) {
+        bucket++;
+    }
+    h->hist[bucket]++;
+
+    if (++h->samples % LATENCY_LOG_INTERVAL == 0) {
+        char text[160];
+        int len = 0;
+        for (size_t i = 0; i < LATENCY_BUCKETS && len < (int)sizeof(text); i++) {
+            if (i < LATENCY_BUCKETS - 1) {
+                len += snprintf(text + len, sizeof(text) - len, "<%lld:%lu ", (long long)LATENCY_LIMIT_US[i], (unsigned long)h->hist[i]);
             } else {
-                strncpy(tokens[token_count], ptr, comma - ptr);
-                tokens[token_count][comma - ptr] = '\0';
-                token_count++;
-                ptr = comma + 1;
+                len += snprintf(text + len, sizeof(text) - len, ">=%lld:%lu", (long long)LATENCY_LIMIT_US[i - 1], (unsigned long)h->hist[i]);
             }
         }
-        
-        // Status (V = inválido, A = ativo)
-        if (strcmp(tokens[2], "A") == 0) {
-            // Latitude
-            double latitude = nmea_to_decimal(tokens[3], tokens[4][0]);
-
-            // Longitude
-            double longitude = nmea_to_decimal(tokens[5], tokens[6][0]);
-
-            // Velocidade em nós
-            double speed_knots = atof(tokens[7]);
-
-            // Converte a velocidade para km/h
-            velocidade = speed_knots * 1.852;
-
-            // Extração de horário UTC (hhmmss.ss)
-            char utc_time[16];
-            strncpy(utc_time, tokens[1], sizeof(utc_time));
-
-            int hours, minutes, seconds;
-            sscanf(utc_time, "%2d%2d%2d", &hours, &minutes, &seconds);
-
-            // Extração de data (ddmmyy)
-            char date[16];
-            strncpy(date, tokens[9], sizeof(date));
-
-            int day, month, year;
-            sscanf(date, "%2d%2d%2d", &day, &month, &year);
-            year += 2000; // Ajustar para ano completo
-
-            // Imprime resultados
-            
-            /*
-            printf("Data (UTC): %02d/%02d/%04d\n", day, month, year);
-            printf("Hora (UTC): %02d:%02d:%02d\n", hours, minutes, seconds);
-            printf("Latitude: %.8f\n", latitude);
-            printf("Longitude: %.8f\n", longitude);
-            printf("Velocidade: %.2f km/h\n\n", speed_kmh);
-            */
-
-            // Verificação de passagem em checkpoints
-            process_position(latitude, longitude);
-
-        } else {
-            printf("Sem sinal de GPS, aguarde.\n");
+        ESP_LOGI("LATENCIA", "%s (us): %s", h->label, text);
+    }
+}
+
+// Entrega as bordas de PPS lidas na ISR à base de tempo, antes do próximo fix
+static void drain_pps(void){
+    int64_t edge_us;
+    while (pps_queue && xQueueReceive(pps_queue, &edge_us, 0) == pdTRUE) {
+        gnss_pipeline_pps_edge(&gnss, edge_us);
+    }
+}
+
+// Publica a foto do estado ao vivo para o portal, sem sprintf e sem mutex
+static void publish_telemetry(const GnssFix *fix){
+    static Telemetry snapshot; // Só a task da UART escreve aqui
+
+    snapshot.valid = fix->valid;
+    snapshot.utc_ms = fix->utc_ms;
+    if (fix->valid) {
+        snapshot.lat_e7 = fix->lat_e7;
+        snapshot.lon_e7 = fix->lon_e7;
+        if (fix->fields & GNSS_HAS_SPEED) {
+            snapshot.speed_kmh = fix->speed_kmh;
+        }
+    }
+    snapshot.lap_started = lap_state.started;
+    snapshot.live_us = lap_state.started ? lap_state.live_time - lap_state.last_checkpoint_time : 0;
+    snapshot.current = lap_current;
+    snapshot.last = lap_last;
+    telemetry_publish(&snapshot);
+}
+
+// Consumidor de log dos eventos de volta: formata os tempos aqui, fora da task da UART, e
+// avisa quando ficou para trás e perdeu eventos
+#define EVENT_LOG_PERIOD_MS 200
+
+static void event_log_task(void *arg){
+    LapEventReader reader;
+    LapEvent event;
+    uint32_t dropped = 0;
+    char text[20];
+
+    lap_events_reader_init(&reader);
+    while (1) {
+        while (lap_events_read(&reader, &event)) {
+            lap_format_time(text, sizeof(text), event.duration_us);
+            switch (event.type) {
+            case LAP_EVENT_LAP_START:
+                ESP_LOGI("VOLTA", "Volta %u iniciada", event.lap);
+                break;
+            case LAP_EVENT_SECTOR:
+                ESP_LOGI("VOLTA", "Volta %u, setor %u: %s", event.lap, event.sector, text);
+                break;
+            case LAP_EVENT_LAP_COMPLETE:
+                ESP_LOGI("VOLTA", "Volta %u: %s", event.lap, text);
+                break;
+            case LAP_EVENT_LAP_INVALID:
+                ESP_LOGW("VOLTA", "Volta %u invalida apos %u setores (%s)", event.lap, event.sector, text);
+                break;
+            case LAP_EVENT_FIX_LOST:
+                ESP_LOGW("VOLTA", "Sinal de GPS perdido");
+                break;
+            default:
+                break;
+            }
         }
+        if (reader.dropped != dropped) {
+            ESP_LOGW("VOLTA", "%lu eventos perdidos pelo log", (unsigned long)(reader.dropped - dropped));
+            dropped = reader.dropped;
+        }
+        vTaskDelay(pdMS_TO_TICKS(EVENT_LOG_PERIOD_MS));
+    }
+}
+
+// Recebe cada fix completo, depois do motor de voltas. epoch_us é o instante da medição
+// estimado pela base de tempo.
+static void on_gnss_fix(const GnssFix *fix, int64_t epoch_us, void *ctx){
+    int64_t now_us = esp_timer_get_time(); // process_position acabou de voltar
+
+    publish_telemetry(fix);
+    portal_notify(); // Acorda o envio ao vivo para o portal
+
+    if (fix->valid) {
+        // Imprime resultados
+        
+        /*
+        printf("Data (UTC): %02d/%02d/%04d\n", fix->day, fix->month, fix->year);
+        printf("Hora (UTC): %02lu:%02lu:%02lu.%03lu\n", (unsigned long)(fix->utc_ms / 3600000),
+               (unsigned long)(fix->utc_ms / 60000 % 60), (unsigned long)(fix->utc_ms / 1000 % 60),
+               (unsigned long)(fix->utc_ms % 1000));
+        printf("Latitude: %.7f\n", fix->lat_e7 * 1e-7);
+        printf("Longitude: %.7f\n", fix->lon_e7 * 1e-7);
+        printf("Velocidade: %.2f km/h\n", fix->speed_kmh);
+        printf("Satelites: %d, HDOP: %.1f\n\n", fix->satellites, fix->hdop);
+        */
+
+        // Latência até o fim do processamento pelo motor de voltas
+        latency_record(&uart_latency, now_us - fix->complete_us);
+        latency_record(&epoch_latency, now_us - epoch_us);
+
+    } else {
+        printf("Sem sinal de GPS, aguarde.\n");
     }
 }
 
+// Encaminha cada linha NMEA ao montador de épocas.
+// arrival_us é o instante em que o fim da linha chegou na UART.
+void process_nmea_line(const char *line, size_t len, int64_t arrival_us){
+    drain_pps();
+    // Os campos são lidos direto do buffer da linha, sem cópia
+    gnss_pipeline_nmea_line(&gnss, line, len, arrival_us);
+}
+
+#if CONFIG_LAP_TIMER_GNSS_NMEA
 // Função para ler a porta UART, armazenar cada linha em buffer e enviar para process_nmea_line()
 static void rx_task(void *arg)
 {
     static const char *RX_TASK_TAG = "RX_TASK";
     esp_log_level_set(RX_TASK_TAG, ESP_LOG_INFO);
 
-    uint8_t *data = (uint8_t *)malloc(RX_BUF_SIZE + 1); // Buffer de recepção
-    if (!data) {
-        ESP_LOGE(RX_TASK_TAG, "Failed to allocate memory for RX buffer");
+    if (!uart_queue) {
+        ESP_LOGE(RX_TASK_TAG, "UART driver not installed");
         vTaskDelete(NULL);
         return;
     }
 
-    char *line_buffer = (char *)malloc(RX_BUF_SIZE); // Aloca dinamicamente o buffer de linha
-    if (!line_buffer) {
-        ESP_LOGE(RX_TASK_TAG, "Failed to allocate memory for line buffer");
-        free(data);
+    // Montador de linhas: a UART escreve direto nele e as linhas são lidas no lugar
+    LineAssembler *assembler = (LineAssembler *)malloc(sizeof(LineAssembler));
+    if (!assembler) {
+        ESP_LOGE(RX_TASK_TAG, "Failed to allocate memory for line assembler");
         vTaskDelete(NULL);
         return;
     }
-    memset(line_buffer, 0, RX_BUF_SIZE); // Preenche com zeros
+    line_asm_init(assembler);
 
-    int line_pos = 0; // Posição atual no buffer de linha
+    uint32_t reported_rejects = 0;  // Descartes já mostrados no log
+    int64_t last_reject_log = 0;
+    uart_event_t event;
 
     while (1) {
-        // Lê os dados recebidos na UART
-        int rxBytes = uart_read_bytes(UART_NUM_2, data, RX_BUF_SIZE, 100 / portTICK_PERIOD_MS);
-        if (rxBytes > 0) {
-            data[rxBytes] = '\0'; // Finaliza a string recebida
-            //ESP_LOGI(RX_TASK_TAG, "Read %d bytes: '%s'", rxBytes, data); // Mostra o log do que foi lido na porta UART
-
-            for (int i = 0; i < rxBytes; i++) {
-                char c = data[i];
-
-                // Se for um caractere de nova linha, processa a linha
-                if (c == '\n') {
-                    line_buffer[line_pos] = '\0'; // Finaliza a linha
-                    //ESP_LOGI(RX_TASK_TAG, "Processing line: %s", line_buffer); // Mostra o log de qual linha esta sendo enviar para processamento
-
-                    // Processa a linha NMEA
-                    process_nmea_line(line_buffer);
-
-                    // Reseta o buffer de linha
-                    memset(line_buffer, 0, RX_BUF_SIZE);
-                    line_pos = 0;
-                } else if (c != '\r' && line_pos < RX_BUF_SIZE - 1) {
-                    // Adiciona o caractere ao buffer de linha, ignorando '\r'
-                    line_buffer[line_pos++] = c;
+        // Pista nova do portal: carregada aqui, entre dois fixes, nunca durante process_position
+        lap_engine_apply_pending();
+
+        // Espera o driver da UART avisar que chegou um '\n' (ou um erro)
+        if (xQueueReceive(uart_queue, &event, pdMS_TO_TICKS(TRACK_POLL_MS)) != pdTRUE) {
+            continue;
+        }
+        int64_t arrival_us = esp_timer_get_time(); // Chegada do fim da sentença
+
+        switch (event.type) {
+        case UART_PATTERN_DET: {
+            // Lê até o '\n' detectado; o restante continua no buffer do driver
+            int pos = uart_pattern_pop_pos(UART_NUM_2);
+            if (pos < 0) {
+                // Fila de posições cheia: descarta o que está no buffer e recomeça
+                uart_flush_input(UART_NUM_2);
+                line_asm_reset(assembler);
+                break;
+            }
+
+            int remaining = pos + 1;
+            while (remaining > 0) {
+                size_t space;
+                char *dst = line_asm_reserve(assembler, &space);
+                int rxBytes = uart_read_bytes(UART_NUM_2, dst, remaining < (int)space ? remaining : (int)space, 0);
+                if (rxBytes <= 0) {
+                    ESP_LOGE(RX_TASK_TAG, "UART read error");
+                    break;
+                }
+                line_asm_commit(assembler, rxBytes);
+                remaining -= rxBytes;
+
+                // Processa cada linha NMEA completa direto do buffer
+                const char *line;
+                size_t len;
+                while (line_asm_next(assembler, &line, &len)) {
+                    //ESP_LOGI(RX_TASK_TAG, "Processing line: %s", line); // Mostra o log de qual linha esta sendo enviar para processamento
+                    process_nmea_line(line, len, arrival_us);
                 }
             }
-        } else if (rxBytes < 0) {
-            ESP_LOGE(RX_TASK_TAG, "UART read error");
+
+            // Linhas descartadas aparecem no log no máximo uma vez por segundo
+            uint32_t rejects = assembler->overlong + assembler->garbage + assembler->bad_checksum;
+            if (rejects != reported_rejects && arrival_us - last_reject_log > 1000000) {
+                ESP_LOGW(RX_TASK_TAG, "Linhas descartadas: %lu longas demais, %lu invalidas, %lu checksum",
+                         (unsigned long)assembler->overlong, (unsigned long)assembler->garbage,
+                         (unsigned long)assembler->bad_checksum);
+                reported_rejects = rejects;
+                last_reject_log = arrival_us;
+            }
+            break;
+        }
+
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            // Estouro de buffer: dados perdidos, recomeça do zero
+            ESP_LOGW(RX_TASK_TAG, "UART overflow");
+            uart_flush_input(UART_NUM_2);
+            xQueueReset(uart_queue);
+            line_asm_reset(assembler);
+            break;
+
+        default:
+            // UART_DATA e demais eventos: os bytes ficam no buffer até o próximo '\n'
+            break;
+        }
+    }
+
+    free(assembler); // Libera a memória alocada para o montador de linhas
+    vTaskDelete(NULL);
+}
+#else
+// Lê a porta UART com o receptor em UBX: os bytes vão direto ao leitor de quadros, que
+// entrega cada NAV-PVT ao motor de voltas. Sem texto, não há '\n' para detectar; o driver avisa
+// com UART_DATA quando a linha fica ociosa no fim do quadro.
+static void rx_task(void *arg)
+{
+    static const char *RX_TASK_TAG = "RX_TASK";
+    esp_log_level_set(RX_TASK_TAG, ESP_LOG_INFO);
+
+    if (!uart_queue) {
+        ESP_LOGE(RX_TASK_TAG, "UART driver not installed");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    UbxParser *parser = &gnss.ubx;
+    uint8_t *data = (uint8_t *)malloc(RX_BUF_SIZE);
+    if (!data) {
+        ESP_LOGE(RX_TASK_TAG, "Failed to allocate memory for UBX buffer");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    uint32_t reported_rejects = 0;  // Descartes já mostrados no log
+    int64_t last_reject_log = 0;
+    uart_event_t event;
+
+    while (1) {
+        lap_engine_apply_pending(); // Pista nova do portal, entre dois fixes
+
+        if (xQueueReceive(uart_queue, &event, pdMS_TO_TICKS(TRACK_POLL_MS)) != pdTRUE) {
+            continue;
+        }
+        int64_t arrival_us = esp_timer_get_time(); // Chegada do fim do quadro
+
+        switch (event.type) {
+        case UART_DATA: {
+            int remaining = (int)event.size;
+            while (remaining > 0) {
+                int rxBytes = uart_read_bytes(UART_NUM_2, data, remaining < RX_BUF_SIZE ? remaining : RX_BUF_SIZE, 0);
+                if (rxBytes <= 0) {
+                    break;
+                }
+                drain_pps();
+                gnss_pipeline_ubx(&gnss, data, rxBytes, arrival_us);
+                remaining -= rxBytes;
+            }
+
+            // Quadros descartados aparecem no log no máximo uma vez por segundo
+            if (parser->bad_checksum != reported_rejects && arrival_us - last_reject_log > 1000000) {
+                ESP_LOGW(RX_TASK_TAG, "Quadros UBX descartados: %lu checksum, %lu bytes fora de quadro",
+                         (unsigned long)parser->bad_checksum, (unsigned long)parser->skipped);
+                reported_rejects = parser->bad_checksum;
+                last_reject_log = arrival_us;
+            }
+            break;
+        }
+
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            // Estouro de buffer: dados perdidos, volta a procurar a sincronia
+            ESP_LOGW(RX_TASK_TAG, "UART overflow");
+            uart_flush_input(UART_NUM_2);
+            xQueueReset(uart_queue);
+            ubx_parser_reset(parser);
+            break;
+
+        default:
+            break;
         }
     }
 
     free(data);
-    free(line_buffer); // Libera a memória alocada para o buffer de linha
     vTaskDelete(NULL);
 }
+#endif
+
+#if CONFIG_LAP_TIMER_ENGINE_BENCHMARK
+#define BENCH_LAPS 5
+#define BENCH_STEPS 40                  // Fixes por trecho entre duas linhas
+
+// Percurso sintético a 10 Hz passando pelos centros das linhas da pista, na ordem. Os fixes
+// ficam no meio de cada passo, nunca exatamente sobre uma linha.
+static void bench_fix(const TrackDef *track, int n, int32_t *lat_e7, int32_t *lon_e7, int64_t *time_us){
+    int leg = n / BENCH_STEPS % track->gate_count;
+    const TrackGate *a = &track->gates[leg];
+    const TrackGate *b = &track->gates[(leg + 1) % track->gate_count];
+    double f = (n % BENCH_STEPS + 0.5) / BENCH_STEPS;
+
+    *lat_e7 = (int32_t)lround((a->lat + (b->lat - a->lat) * f) * 1e7);
+    *lon_e7 = (int32_t)lround((a->lon + (b->lon - a->lon) * f) * 1e7);
+    *time_us = (int64_t)n * 100000;
+}
+
+// Mede em ciclos de CPU o caminho de cada fix no motor (projeção e teste da linha) na precisão
+// do menuconfig e na cópia em double, e compara os instantes de cruzamento dos dois
+static void run_engine_benchmark(void){
+    const TrackDef *track = lap_engine_track();
+    const int fixes = BENCH_LAPS * BENCH_STEPS * track->gate_count;
+    uint32_t cycles = 0, ref_cycles = 0;
+    int64_t last = -1, ref_last = -1, max_err = 0;
+    int crossings = 0, mismatches = 0;
+    int32_t lat_e7, lon_e7;
+    int64_t time_us;
+
+    lap_engine_load_track(track);
+    ref_lap_engine_load_track(track);
+    for (int n = 0; n < fixes; n++) {
+        bench_fix(track, n, &lat_e7, &lon_e7, &time_us);
+        uint32_t start = esp_cpu_get_cycle_count();
+        process_position(lat_e7, lon_e7, time_us);
+        uint32_t middle = esp_cpu_get_cycle_count();
+        ref_process_position(lat_e7, lon_e7, time_us);
+        ref_cycles += esp_cpu_get_cycle_count() - middle;
+        cycles += middle - start;
+
+        // Cada passagem por uma linha atualiza last_checkpoint_time com o instante interpolado
+        bool crossed = lap_state.started && lap_state.last_checkpoint_time != last;
+        bool ref_crossed = ref_lap_state.started && ref_lap_state.last_checkpoint_time != ref_last;
+        if (crossed != ref_crossed) {
+            mismatches++;
+        } else if (crossed) {
+            int64_t err = llabs(lap_state.last_checkpoint_time - ref_lap_state.last_checkpoint_time);
+            max_err = err > max_err ? err : max_err;
+            crossings++;
+        }
+        last = lap_state.last_checkpoint_time;
+        ref_last = ref_lap_state.last_checkpoint_time;
+    }
+
+    // O percurso sintético não conta como sessão
+    lap_engine_load_track(track);
+    lap_last = (LapResult){ 0 };
+
+#if CONFIG_LAP_TIMER_ENGINE_DOUBLE
+    const char *precision = "double";
+#else
+    const char *precision = "float";
+#endif
+    ESP_LOGI("ENGINE", "motor (%s): %lu ciclos/fix", precision, (unsigned long)(cycles / fixes));
+    ESP_LOGI("ENGINE", "motor de referencia (double): %lu ciclos/fix", (unsigned long)(ref_cycles / fixes));
+    ESP_LOGI("ENGINE", "%d cruzamentos, %d divergentes, diferenca maxima %lld us",
+             crossings, mismatches, (long long)max_err);
+}
+#endif
 
 void app_main(void){
 
     init_uart(); //Chama função para inicializar a porta UART
+#if CONFIG_LAP_TIMER_GNSS_AUTOCONFIG
+    configure_receiver(); // Sobe o baud rate e a taxa de navegação do receptor
+#endif
+
+    lap_engine_load_track(lap_engine_track()); // Prepara o referencial e as linhas da pista padrão
+#if CONFIG_LAP_TIMER_TIME_GNSS
+    gnss_pipeline_init(&gnss, true, on_gnss_fix, NULL);
+#else
+    gnss_pipeline_init(&gnss, false, on_gnss_fix, NULL);
+#endif
+#if CONFIG_LAP_TIMER_PPS_GPIO >= 0
+    init_pps(); // Pulso por segundo do receptor, para datar os fixes com precisão de microssegundos
+#endif
+
+#if CONFIG_LAP_TIMER_ENGINE_BENCHMARK
+    run_engine_benchmark();
+#endif
 
     printf("Inicializando portal cativo...\n");
     esp_err_t ret = nvs_flash_init();
@@ -361,6 +571,7 @@ void app_main(void){
     start_portal_cativo();
 
     xTaskCreate(rx_task, "uart_rx_task", 4096, NULL, configMAX_PRIORITIES - 1, NULL); // Cria a task que lê a porta UART
+    xTaskCreate(event_log_task, "lap_event_log", 3072, NULL, tskIDLE_PRIORITY + 1, NULL); // Log das voltas, sem atrasar a UART
 
     /*
     while (1) {
@@ -0,0 +1,157 @@
+#include <string.h>
+#include "line_assembler.h"
+
+// Etapas da verificação do checksum, avançadas a cada byte examinado
+enum {
+    CS_WAIT_START,  // Antes do '$'
+    CS_SUM,         // Somando (XOR) os bytes até o '*'
+    CS_HEX,         // Lendo os dois dígitos hexadecimais
+    CS_INVALID,     // Formato inválido; a linha será rejeitada
+};
+
+void line_asm_init(LineAssembler *la){
+    line_asm_reset(la);
+    la->lines = 0;
+    la->overlong = 0;
+    la->garbage = 0;
+    la->bad_checksum = 0;
+}
+
+// Descarta os dados pendentes mantendo os contadores
+void line_asm_reset(LineAssembler *la){
+    la->head = 0;
+    la->scan = 0;
+    la->tail = 0;
+    la->discarding = false;
+    la->cs_state = CS_WAIT_START;
+}
+
+// Valor de um dígito hexadecimal, ou -1
+static int hex_value(char c){
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// Avança o checksum com um byte da linha (exceto o '\n')
+static inline void checksum_feed(LineAssembler *la, char c){
+    switch (la->cs_state) {
+    case CS_WAIT_START:
+        if (c == '$') {
+            la->cs_state = CS_SUM;
+            la->cs_sum = 0;
+        } else {
+            la->cs_state = CS_INVALID;
+        }
+        break;
+    case CS_SUM:
+        if (c == '*') {
+            la->cs_state = CS_HEX;
+            la->cs_value = 0;
+            la->cs_digits = 0;
+        } else {
+            la->cs_sum ^= (uint8_t)c;
+        }
+        break;
+    case CS_HEX: {
+        int v = hex_value(c);
+        if (v >= 0 && la->cs_digits < 2) {
+            la->cs_value = (uint8_t)((la->cs_value << 4) | v);
+            la->cs_digits++;
+        } else if (c != '\r') {
+            la->cs_state = CS_INVALID;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// Devolve onde a UART deve escrever os próximos bytes e quanto espaço há.
+// Quando o fim do buffer está próximo, só o pedaço da linha incompleta volta para o
+// início (no máximo LINE_ASM_MAX_LINE bytes, uma vez por volta do buffer).
+char *line_asm_reserve(LineAssembler *la, size_t *space){
+    if (la->head > 0 && LINE_ASM_BUF_SIZE - la->tail < LINE_ASM_MAX_LINE) {
+        size_t pending = la->tail - la->head;
+        memmove(la->buf, la->buf + la->head, pending);
+        la->scan -= la->head;
+        la->tail = pending;
+        la->head = 0;
+    }
+    *space = LINE_ASM_BUF_SIZE - la->tail;
+    return la->buf + la->tail;
+}
+
+// Confirma os bytes escritos em line_asm_reserve
+void line_asm_commit(LineAssembler *la, size_t len){
+    la->tail += len;
+}
+
+// Entrega a próxima linha completa com checksum válido (sem "\r\n", terminada em '\0' no
+// próprio buffer). O checksum é calculado enquanto os bytes são examinados, então uma
+// sentença corrompida nunca chega ao parser. O ponteiro vale até a próxima chamada de
+// line_asm_reserve.
+bool line_asm_next(LineAssembler *la, const char **line, size_t *len){
+    while (la->scan < la->tail) {
+        char c = la->buf[la->scan++];
+
+        if (c != '\n') {
+            if (!la->discarding && la->scan - la->head > LINE_ASM_MAX_LINE) {
+                la->discarding = true;
+                la->overlong++;
+            }
+            checksum_feed(la, c);
+            continue;
+        }
+
+        size_t start = la->head;
+        size_t end = la->scan - 1;
+        bool checksum_ok = la->cs_state == CS_HEX && la->cs_digits == 2 && la->cs_value == la->cs_sum;
+        la->head = la->scan;
+        la->cs_state = CS_WAIT_START;
+
+        if (la->discarding) {
+            // Fim da linha longa demais: volta ao normal na próxima
+            la->discarding = false;
+            continue;
+        }
+        if (end > start && la->buf[end - 1] == '\r') {
+            end--;
+        }
+        if (end == start) {
+            continue; // Linha vazia
+        }
+        la->buf[end] = '\0';
+
+        if (la->buf[start] != '$') {
+            la->garbage++;
+            continue;
+        }
+        if (!checksum_ok) {
+            // Sentença corrompida: rejeitada antes de qualquer tokenização
+            la->bad_checksum++;
+            continue;
+        }
+
+        la->lines++;
+        *line = la->buf + start;
+        *len = end - start;
+        return true;
+    }
+
+    // Tudo consumido: recomeça do início do buffer sem mover nada
+    if (la->head == la->tail || la->discarding) {
+        la->head = 0;
+        la->scan = 0;
+        la->tail = 0;
+    }
+    return false;
+}
@@ -0,0 +1,35 @@
+#ifndef LINE_ASSEMBLER_H
+#define LINE_ASSEMBLER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LINE_ASM_BUF_SIZE 2048      // Bytes recebidos da UART aguardando o fim da linha
+#define LINE_ASM_MAX_LINE 256       // Linhas maiores que isso são descartadas como longas demais
+
+// Montador de linhas: a UART escreve direto no buffer e as linhas completas são entregues
+// como ponteiro + tamanho dentro dele, sem cópia e sem limpar o buffer a cada linha
+typedef struct {
+    char buf[LINE_ASM_BUF_SIZE];
+    size_t head;            // Início da linha em montagem
+    size_t scan;            // Próximo byte a ser examinado
+    size_t tail;            // Fim dos dados recebidos
+    bool discarding;        // Linha atual passou de LINE_ASM_MAX_LINE; ignora até o '\n'
+    uint8_t cs_state;       // Etapa da verificação do checksum "*hh" da linha atual
+    uint8_t cs_sum;         // XOR acumulado dos bytes entre '$' e '*'
+    uint8_t cs_value;       // Valor hexadecimal lido após o '*'
+    uint8_t cs_digits;      // Dígitos hexadecimais lidos após o '*'
+    uint32_t lines;         // Linhas entregues
+    uint32_t overlong;      // Linhas descartadas por tamanho
+    uint32_t garbage;       // Linhas descartadas por não começarem com '$'
+    uint32_t bad_checksum;  // Sentenças descartadas por checksum ausente ou inválido
+} LineAssembler;
+
+void line_asm_init(LineAssembler *la);
+void line_asm_reset(LineAssembler *la);
+char *line_asm_reserve(LineAssembler *la, size_t *space);
+void line_asm_commit(LineAssembler *la, size_t len);
+bool line_asm_next(LineAssembler *la, const char **line, size_t *len);
+
+#endif // LINE_ASSEMBLER_H
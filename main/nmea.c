@@ -0,0 +1,432 @@
+#include <string.h>
+#include <stdint.h>
+#include "nmea.h"
+
+// Prepara o tokenizador para percorrer a linha sem copiar os campos
+void nmea_tokenizer_init(NmeaTokenizer *tok, const char *line, size_t len){
+    tok->cur = line;
+    tok->end = line + len;
+    tok->done = false;
+}
+
+// Entrega o próximo campo da linha; os campos terminam em ',' ou no '*' do checksum
+bool nmea_next_field(NmeaTokenizer *tok, NmeaField *field){
+    if (tok->done) {
+        return false;
+    }
+
+    const char *p = tok->cur;
+    while (p < tok->end && *p != ',' && *p != '*' && *p != '\0') {
+        p++;
+    }
+
+    field->ptr = tok->cur;
+    field->len = (size_t)(p - tok->cur);
+
+    if (p < tok->end && *p == ',') {
+        tok->cur = p + 1;
+    } else {
+        // Fim da linha ou início do checksum: não há mais campos
+        tok->cur = p;
+        tok->done = true;
+    }
+    return true;
+}
+
+// Compara o campo com um texto sem precisar terminá-lo com '\0'
+bool nmea_field_equals(const NmeaField *field, const char *text){
+    size_t n = strlen(text);
+    return field->len == n && memcmp(field->ptr, text, n) == 0;
+}
+
+// Converte 'digits' dígitos a partir de 'offset' em inteiro (ex.: hh, mm, ss de hhmmss)
+int nmea_field_to_int(const NmeaField *field, size_t offset, size_t digits){
+    int value = 0;
+    for (size_t i = offset; i < offset + digits && i < field->len; i++) {
+        char c = field->ptr[i];
+        if (c < '0' || c > '9') {
+            break;
+        }
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+
+// Converte um número decimal (ex.: 12.345) diretamente do buffer da linha, em precisão simples
+float nmea_field_to_float(const NmeaField *field){
+    const char *p = field->ptr;
+    const char *end = field->ptr + field->len;
+    bool negative = false;
+    float value = 0.0f;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10.0f + (*p++ - '0');
+    }
+    if (p < end && *p == '.') {
+        float scale = 0.1f;
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            value += (*p++ - '0') * scale;
+            scale *= 0.1f;
+        }
+    }
+    return negative ? -value : value;
+}
+
+// Converte coordenadas NMEA (ddmm.mmmmm / dddmm.mmmmm) para 1e-7 grau em uma única passada,
+// usando apenas aritmética inteira (1e-7 grau equivale a ~1,1 cm). Retorna false se o campo ou
+// a direção estiverem malformados (um campo corrompido pode passar pelo checksum).
+bool nmea_to_e7(const NmeaField *coord, char direction, int32_t *value){
+    const char *p = coord->ptr;
+    const char *end = coord->ptr + coord->len;
+    const char *dot = p;
+    uint32_t degrees = 0;
+    uint32_t minutes_e7 = 0;    // Minutos em unidades de 1e-7 minuto
+    uint32_t scale = 10000000;
+
+    while (dot < end && *dot != '.') {
+        dot++;
+    }
+    // Os dois dígitos antes do ponto são os minutos; o restante são os graus (2 ou 3 dígitos)
+    if (dot - p < 3 || dot - p > 5) {
+        return false;
+    }
+    if (direction != 'N' && direction != 'S' && direction != 'E' && direction != 'W') {
+        return false;
+    }
+
+    for (; p < dot - 2; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        degrees = degrees * 10 + (*p - '0');
+    }
+    for (; p < dot; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        minutes_e7 = minutes_e7 * 10 + (*p - '0');
+    }
+    if (degrees > 180 || minutes_e7 >= 60) {
+        return false;
+    }
+    minutes_e7 *= scale;
+
+    // Fração dos minutos: até 7 casas são aproveitadas, o resto só precisa ser dígito
+    for (p = dot + 1; p < end; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        if (scale > 1) {
+            scale /= 10;
+            minutes_e7 += (uint32_t)(*p - '0') * scale;
+        }
+    }
+
+    // Graus + minutos / 60, arredondado para o 1e-7 grau mais próximo
+    *value = (int32_t)(degrees * 10000000u + (minutes_e7 + 30) / 60);
+
+    // Aplica sinal baseado na direção
+    if (direction == 'S' || direction == 'W') {
+        *value = -*value;
+    }
+    return true;
+}
+
+// Converte o horário hhmmss.sss em milissegundos do dia; UINT32_MAX se o campo estiver vazio
+uint32_t nmea_parse_utc_ms(const NmeaField *field){
+    if (field->len < 6) {
+        return UINT32_MAX;
+    }
+    uint32_t ms = (uint32_t)(nmea_field_to_int(field, 0, 2) * 3600 +
+                             nmea_field_to_int(field, 2, 2) * 60 +
+                             nmea_field_to_int(field, 4, 2)) * 1000;
+
+    // Fração de segundo: até 3 casas
+    uint32_t scale = 100;
+    for (size_t i = 7; i < field->len && field->ptr[6] == '.' && scale > 0; i++, scale /= 10) {
+        char c = field->ptr[i];
+        if (c < '0' || c > '9') {
+            break;
+        }
+        ms += (uint32_t)(c - '0') * scale;
+    }
+    return ms;
+}
+
+// Cada tratador percorre os campos a partir do índice 1 (o horário, quando existe) e
+// preenche só o que a sentença carrega
+
+// Posição de RMC ou GGA. Com uma coordenada malformada a época inteira fica inválida, mesmo que
+// outra sentença já tenha trazido posição: não há como saber qual das duas está certa.
+static void set_position(GnssFix *fix, const NmeaField *lat, char lat_dir, const NmeaField *lon, char lon_dir){
+    int32_t lat_e7, lon_e7;
+
+    if (fix->malformed) {
+        return;
+    }
+    if (nmea_to_e7(lat, lat_dir, &lat_e7) && nmea_to_e7(lon, lon_dir, &lon_e7) &&
+        lat_e7 >= -900000000 && lat_e7 <= 900000000) {
+        fix->lat_e7 = lat_e7;
+        fix->lon_e7 = lon_e7;
+        fix->fields |= GNSS_HAS_POSITION;
+        fix->valid = true;
+    } else {
+        fix->lat_e7 = 0;
+        fix->lon_e7 = 0;
+        fix->fields &= ~GNSS_HAS_POSITION;
+        fix->valid = false;
+        fix->malformed = true;
+    }
+}
+
+static void handle_rmc(NmeaTokenizer *tok, GnssFix *fix){
+    NmeaField field, lat = { 0 }, lon = { 0 };
+    char lat_dir = 0, lon_dir = 0;
+    bool active = false;
+
+    for (int index = 1; nmea_next_field(tok, &field); index++) {
+        switch (index) {
+        case 2: active = nmea_field_equals(&field, "A"); break;   // Status (V = inválido, A = ativo)
+        case 3: lat = field; break;
+        case 4: lat_dir = field.len ? field.ptr[0] : 0; break;
+        case 5: lon = field; break;
+        case 6: lon_dir = field.len ? field.ptr[0] : 0; break;
+        case 7: // Velocidade em nós convertida para km/h
+            if (field.len) {
+                fix->speed_kmh = nmea_field_to_float(&field) * 1.852f;
+                fix->fields |= GNSS_HAS_SPEED;
+            }
+            break;
+        case 8: // Rumo verdadeiro
+            if (field.len) {
+                fix->course_deg = nmea_field_to_float(&field);
+                fix->fields |= GNSS_HAS_COURSE;
+            }
+            break;
+        case 9: // Data (ddmmyy)
+            if (field.len >= 6) {
+                fix->day = nmea_field_to_int(&field, 0, 2);
+                fix->month = nmea_field_to_int(&field, 2, 2);
+                fix->year = nmea_field_to_int(&field, 4, 2) + 2000;
+                fix->fields |= GNSS_HAS_DATE;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (active && lat.len && lon.len) {
+        set_position(fix, &lat, lat_dir, &lon, lon_dir);
+    }
+}
+
+static void handle_gga(NmeaTokenizer *tok, GnssFix *fix){
+    NmeaField field, lat = { 0 }, lon = { 0 };
+    char lat_dir = 0, lon_dir = 0;
+
+    for (int index = 1; nmea_next_field(tok, &field); index++) {
+        switch (index) {
+        case 2: lat = field; break;
+        case 3: lat_dir = field.len ? field.ptr[0] : 0; break;
+        case 4: lon = field; break;
+        case 5: lon_dir = field.len ? field.ptr[0] : 0; break;
+        case 6: fix->quality = nmea_field_to_int(&field, 0, 1); break;
+        case 7: fix->satellites = nmea_field_to_int(&field, 0, 2); break;
+        case 8: fix->hdop = nmea_field_to_float(&field); break;
+        case 9:
+            if (field.len) {
+                fix->altitude_m = nmea_field_to_float(&field);
+                fix->fields |= GNSS_HAS_ALTITUDE;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    fix->fields |= GNSS_HAS_QUALITY;
+
+    if (fix->quality > 0 && lat.len && lon.len) {
+        set_position(fix, &lat, lat_dir, &lon, lon_dir);
+    }
+}
+
+static void handle_gsa(NmeaTokenizer *tok, GnssFix *fix){
+    NmeaField field;
+
+    for (int index = 1; nmea_next_field(tok, &field); index++) {
+        switch (index) {
+        case 2: fix->fix_type = nmea_field_to_int(&field, 0, 1); break;
+        case 15: fix->pdop = nmea_field_to_float(&field); break;
+        case 16: fix->hdop = nmea_field_to_float(&field); break;
+        case 17: fix->vdop = nmea_field_to_float(&field); break;
+        default:
+            break;
+        }
+    }
+    fix->fields |= GNSS_HAS_DOP;
+}
+
+static void handle_vtg(NmeaTokenizer *tok, GnssFix *fix){
+    NmeaField field;
+
+    for (int index = 1; nmea_next_field(tok, &field); index++) {
+        if (index == 1 && field.len) {
+            fix->course_deg = nmea_field_to_float(&field);
+            fix->fields |= GNSS_HAS_COURSE;
+        } else if (index == 7 && field.len) {
+            fix->speed_kmh = nmea_field_to_float(&field);
+            fix->fields |= GNSS_HAS_SPEED;
+        }
+    }
+}
+
+static void handle_gst(NmeaTokenizer *tok, GnssFix *fix){
+    NmeaField field;
+
+    for (int index = 1; nmea_next_field(tok, &field); index++) {
+        if (index == 6) {
+            fix->lat_err_m = nmea_field_to_float(&field);
+        } else if (index == 7) {
+            fix->lon_err_m = nmea_field_to_float(&field);
+        }
+    }
+    fix->fields |= GNSS_HAS_ERROR;
+}
+
+// Tabela de despacho indexada por um hash do tipo da sentença (3 letras após o talker).
+// O hash não tem colisões para os tipos tratados; -Woverride-init acusaria se tivesse.
+#define NMEA_HASH(a, b, c) ((unsigned)((a) + (b) + (c)) & 7u)
+
+typedef struct {
+    char type[3];                                   // Tipo da sentença, ex.: "RMC"
+    bool has_time;                                  // Campo 1 é o horário UTC
+    void (*handler)(NmeaTokenizer *tok, GnssFix *fix);
+} NmeaHandler;
+
+static const NmeaHandler handlers[8] = {
+    [NMEA_HASH('R', 'M', 'C')] = { { 'R', 'M', 'C' }, true, handle_rmc },
+    [NMEA_HASH('G', 'G', 'A')] = { { 'G', 'G', 'A' }, true, handle_gga },
+    [NMEA_HASH('G', 'S', 'A')] = { { 'G', 'S', 'A' }, false, handle_gsa },
+    [NMEA_HASH('V', 'T', 'G')] = { { 'V', 'T', 'G' }, false, handle_vtg },
+    [NMEA_HASH('G', 'S', 'T')] = { { 'G', 'S', 'T' }, true, handle_gst },
+};
+
+// Encontra o tratador pelo cabeçalho "$ttSSS" (qualquer talker: GP, GN, GL, GA, GB...)
+static const NmeaHandler *nmea_lookup(const NmeaField *header){
+    if (header->len != 6 || header->ptr[0] != '$') {
+        return NULL;
+    }
+    const char *type = header->ptr + 3;
+    const NmeaHandler *h = &handlers[NMEA_HASH(type[0], type[1], type[2])];
+    if (!h->handler || memcmp(h->type, type, 3) != 0) {
+        return NULL;
+    }
+    return h;
+}
+
+// Interpreta uma sentença RMC isolada (de qualquer talker); retorna false se a linha não for RMC
+bool nmea_parse_rmc(const char *line, size_t len, GnssFix *fix){
+    NmeaTokenizer tok;
+    NmeaField field;
+
+    nmea_tokenizer_init(&tok, line, len);
+    if (!nmea_next_field(&tok, &field) || field.len != 6 || field.ptr[0] != '$' ||
+        memcmp(field.ptr + 3, "RMC", 3) != 0) {
+        return false;
+    }
+
+    memset(fix, 0, sizeof(*fix));
+    NmeaTokenizer peek = tok;
+    if (nmea_next_field(&peek, &field)) {
+        fix->utc_ms = nmea_parse_utc_ms(&field);
+    }
+    handle_rmc(&tok, fix);
+    return true;
+}
+
+void nmea_epoch_init(NmeaEpoch *ep, gnss_fix_cb callback, void *ctx){
+    memset(ep, 0, sizeof(*ep));
+    ep->callback = callback;
+    ep->ctx = ctx;
+}
+
+// Entrega a época ao callback, uma única vez. arrival_us é a chegada da sentença que a completou.
+static void epoch_emit(NmeaEpoch *ep, int64_t arrival_us){
+    if (ep->active && !ep->emitted) {
+        ep->emitted = true;
+        ep->epochs++;
+        ep->fix.complete_us = arrival_us;
+        ep->callback(&ep->fix, ep->ctx);
+    }
+}
+
+// Começa uma nova época, aprendendo quantas sentenças a anterior teve
+static void epoch_start(NmeaEpoch *ep, uint32_t utc_ms, int64_t arrival_us){
+    if (ep->active) {
+        ep->expected = ep->count;
+    }
+    memset(&ep->fix, 0, sizeof(ep->fix));
+    ep->fix.utc_ms = utc_ms;
+    ep->fix.local_us = arrival_us;
+    ep->active = true;
+    ep->emitted = false;
+    ep->count = 0;
+}
+
+// Processa uma sentença: as que têm o mesmo horário UTC são fundidas em um único GnssFix,
+// entregue ao callback uma vez por época. A época é entregue assim que chega o número de
+// sentenças visto na época anterior; se faltar alguma, sai quando o horário mudar.
+// Retorna false se a sentença não for de um tipo tratado.
+bool nmea_epoch_feed(NmeaEpoch *ep, const char *line, size_t len, int64_t arrival_us){
+    NmeaTokenizer tok;
+    NmeaField field;
+
+    nmea_tokenizer_init(&tok, line, len);
+    if (!nmea_next_field(&tok, &field)) {
+        return false;
+    }
+    const NmeaHandler *h = nmea_lookup(&field);
+    if (!h) {
+        return false;
+    }
+
+    if (h->has_time) {
+        NmeaTokenizer peek = tok;
+        uint32_t utc_ms = UINT32_MAX;
+        if (nmea_next_field(&peek, &field)) {
+            utc_ms = nmea_parse_utc_ms(&field);
+        }
+
+        if (utc_ms == UINT32_MAX) {
+            // Sem horário (receptor sem fix): entrega a sentença sozinha, sem fundir
+            epoch_emit(ep, arrival_us);
+            epoch_start(ep, utc_ms, arrival_us);
+            ep->expected = 0;
+            h->handler(&tok, &ep->fix);
+            epoch_emit(ep, arrival_us);
+            ep->active = false;
+            return true;
+        }
+        if (!ep->active || utc_ms != ep->fix.utc_ms) {
+            // Mudou o horário: a época anterior terminou
+            epoch_emit(ep, arrival_us);
+            epoch_start(ep, utc_ms, arrival_us);
+        }
+    } else if (!ep->active) {
+        return true; // Sentença sem horário antes da primeira época: nada a fundir
+    }
+
+    h->handler(&tok, &ep->fix);
+    ep->count++;
+
+    if (ep->expected && ep->count >= ep->expected) {
+        epoch_emit(ep, arrival_us);
+    }
+    return true;
+}
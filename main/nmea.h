@@ -0,0 +1,50 @@
+#ifndef NMEA_H
+#define NMEA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "gnss_fix.h"
+
+// Campo de uma sentença NMEA: aponta diretamente para o buffer da linha, sem cópia
+typedef struct {
+    const char *ptr;    // Início do campo dentro da linha
+    size_t len;         // Quantidade de caracteres do campo (sem a vírgula)
+} NmeaField;
+
+// Tokenizador por vírgulas que percorre a linha sob demanda
+typedef struct {
+    const char *cur;    // Próximo caractere a ser lido
+    const char *end;    // Fim da região útil da linha
+    bool done;          // Último campo já foi entregue
+} NmeaTokenizer;
+
+// Montador de épocas: funde as sentenças de um mesmo horário UTC em um único GnssFix
+typedef struct {
+    GnssFix fix;            // Época em montagem
+    bool active;            // Há uma época em montagem
+    bool emitted;           // A época atual já foi entregue
+    uint8_t count;          // Sentenças tratadas na época atual
+    uint8_t expected;       // Sentenças vistas na época anterior (0 = ainda desconhecido)
+    uint32_t epochs;        // Épocas entregues
+    gnss_fix_cb callback;
+    void *ctx;
+} NmeaEpoch;
+
+void nmea_tokenizer_init(NmeaTokenizer *tok, const char *line, size_t len);
+bool nmea_next_field(NmeaTokenizer *tok, NmeaField *field);
+
+bool nmea_field_equals(const NmeaField *field, const char *text);
+int nmea_field_to_int(const NmeaField *field, size_t offset, size_t digits);
+float nmea_field_to_float(const NmeaField *field);
+
+bool nmea_to_e7(const NmeaField *coord, char direction, int32_t *value);
+
+uint32_t nmea_parse_utc_ms(const NmeaField *field);
+
+bool nmea_parse_rmc(const char *line, size_t len, GnssFix *fix);
+
+void nmea_epoch_init(NmeaEpoch *ep, gnss_fix_cb callback, void *ctx);
+bool nmea_epoch_feed(NmeaEpoch *ep, const char *line, size_t len, int64_t arrival_us);
+
+#endif // NMEA_H
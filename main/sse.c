@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_http_server.h"
+#include "sse.h"
+#include "telemetry.h"
+#include "lap_events.h"
+
+#define SSE_KEEPALIVE_MS 15000      // Sem novidade por esse tempo, manda um comentário para detectar quem caiu
+
+static const char *TAG = "SSE";
+
+// As conexões /events ficam com a task do SSE: o handler só repassa a requisição assíncrona e
+// libera o servidor. A task acorda a cada fix (sse_notify) e manda para todos os navegadores
+// os eventos de volta novos e uma atualização curta do estado ao vivo, em JSON ou no formato
+// binário do /data.bin.
+typedef struct {
+    httpd_req_t *req;
+    bool bin;               // /events?formato=bin: o estado ao vivo vai em telemetry_pack (base64)
+} SseClient;
+
+// Destino de um envio
+#define SSE_TO_ALL 0
+#define SSE_TO_JSON 1
+#define SSE_TO_BIN 2
+
+static QueueHandle_t sse_new_clients;
+static TaskHandle_t sse_task_handle;
+static SseClient clients[SSE_MAX_CLIENTS];
+static int client_count = 0;
+static TickType_t last_broadcast;
+
+// Chamada pela task da UART depois de cada fix; nunca bloqueia
+void sse_notify(void){
+    if (sse_task_handle) {
+        xTaskNotifyGive(sse_task_handle);
+    }
+}
+
+// Recusa a conexão: a página continua pelo /data
+static void sse_reject(httpd_req_t *req){
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_send(req, NULL, 0);
+    httpd_req_async_handler_complete(req);
+}
+
+static esp_err_t events_handler(httpd_req_t *req){
+    char query[32], format[8];
+    SseClient client = { 0 };
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "formato", format, sizeof(format)) == ESP_OK) {
+        client.bin = strcmp(format, "bin") == 0;
+    }
+    if (httpd_req_async_handler_begin(req, &client.req) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    httpd_resp_set_type(client.req, "text/event-stream");
+    httpd_resp_set_hdr(client.req, "Cache-Control", "no-cache");
+    if (xQueueSend(sse_new_clients, &client, 0) != pdTRUE) {
+        sse_reject(client.req);
+    }
+    return ESP_OK;
+}
+
+// Envia um trecho a um navegador; se falhar, a conexão caiu e é encerrada
+static bool sse_send(httpd_req_t *req, const char *text, int len){
+    if (httpd_resp_send_chunk(req, text, len) == ESP_OK) {
+        return true;
+    }
+    httpd_req_async_handler_complete(req);
+    return false;
+}
+
+static void sse_broadcast(const char *text, int len, int to){
+    last_broadcast = xTaskGetTickCount();
+    for (int i = 0; i < client_count;) {
+        if ((to == SSE_TO_JSON && clients[i].bin) || (to == SSE_TO_BIN && !clients[i].bin)) {
+            i++;
+        } else if (sse_send(clients[i].req, text, len)) {
+            i++;
+        } else {
+            clients[i] = clients[--client_count];
+        }
+    }
+}
+
+static void sse_add_client(const SseClient *client){
+    static const char hello[] = "retry: 2000\n\n"; // Espera do navegador antes de reconectar (ms)
+
+    if (client_count == SSE_MAX_CLIENTS) {
+        sse_reject(client->req);
+        return;
+    }
+    if (sse_send(client->req, hello, sizeof(hello) - 1)) {
+        clients[client_count++] = *client;
+        ESP_LOGI(TAG, "Navegador conectado (%d)", client_count);
+    }
+}
+
+// Codifica em base64, já que o SSE só transporta texto; retorna o tamanho escrito
+static int base64_encode(char *out, const uint8_t *data, size_t len){
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    int n = 0;
+
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len) v |= data[i + 2];
+        out[n++] = digits[v >> 18];
+        out[n++] = digits[(v >> 12) & 63];
+        out[n++] = i + 1 < len ? digits[(v >> 6) & 63] : '=';
+        out[n++] = i + 2 < len ? digits[v & 63] : '=';
+    }
+    return n;
+}
+
+// Estado ao vivo para os dois formatos, montado uma vez e enviado a todos
+static void sse_send_live(const Telemetry *live){
+    static uint8_t bin[TELEMETRY_BIN_MAX];
+    static char text[sizeof("event: bin\ndata: \n\n") + (TELEMETRY_BIN_MAX + 2) / 3 * 4];
+    bool any_json = false, any_bin = false;
+    int len;
+
+    for (int i = 0; i < client_count; i++) {
+        any_bin |= clients[i].bin;
+        any_json |= !clients[i].bin;
+    }
+
+    if (any_json) {
+        if (live->lap_started) {
+            len = snprintf(text, sizeof(text), "event: fix\ndata: {\"velocidade\": %.1f, \"volta_atual\": %lld}\n\n",
+                           live->speed_kmh, (long long)(live->live_us / 1000));
+        } else {
+            len = snprintf(text, sizeof(text), "event: fix\ndata: {\"velocidade\": %.1f, \"volta_atual\": null}\n\n",
+                           live->speed_kmh);
+        }
+        sse_broadcast(text, len, SSE_TO_JSON);
+    }
+    if (any_bin) {
+        size_t size = telemetry_pack(live, bin, sizeof(bin));
+        len = snprintf(text, sizeof(text), "event: bin\ndata: ");
+        len += base64_encode(text + len, bin, size);
+        text[len++] = '\n';
+        text[len++] = '\n';
+        sse_broadcast(text, len, SSE_TO_BIN);
+    }
+}
+
+static void sse_task(void *arg){
+    static Telemetry live;
+    char text[160];
+    LapEventReader reader;
+    LapEvent event;
+    uint32_t version = 0, dropped = 0;
+    SseClient client;
+
+    lap_events_reader_init(&reader);
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SSE_TICK_MS));
+
+        while (xQueueReceive(sse_new_clients, &client, 0) == pdTRUE) {
+            sse_add_client(&client);
+        }
+        if (client_count == 0) {
+            // Ninguém ouvindo: descarta o que passou, sem contar como perda
+            lap_events_reader_init(&reader);
+            continue;
+        }
+
+        // Eventos de volta, na ordem, com os tempos inteiros em ms
+        while (lap_events_read(&reader, &event)) {
+            int len = snprintf(text, sizeof(text),
+                               "event: volta\ndata: {\"tipo\": \"%s\", \"volta\": %u, \"setor\": %u, \"ms\": %lld}\n\n",
+                               lap_event_name(event.type), event.lap, event.sector,
+                               (long long)(event.duration_us / 1000));
+            sse_broadcast(text, len, SSE_TO_ALL);
+        }
+        if (reader.dropped != dropped) {
+            // Eventos perdidos: a página busca o estado completo no /data
+            dropped = reader.dropped;
+            sse_broadcast("event: resync\ndata: {}\n\n", HTTPD_RESP_USE_STRLEN, SSE_TO_ALL);
+        }
+
+        uint32_t current = telemetry_version();
+        if (current != version) {
+            version = current;
+            telemetry_read(&live);
+            sse_send_live(&live);
+        } else if (xTaskGetTickCount() - last_broadcast >= pdMS_TO_TICKS(SSE_KEEPALIVE_MS)) {
+            sse_broadcast(": ping\n\n", HTTPD_RESP_USE_STRLEN, SSE_TO_ALL);
+        }
+    }
+}
+
+// Registra o /events e cria a task que atende as conexões
+void sse_start(httpd_handle_t server){
+    sse_new_clients = xQueueCreate(SSE_MAX_CLIENTS, sizeof(SseClient));
+    xTaskCreate(sse_task, "sse_task", 3072, NULL, 5, &sse_task_handle);
+
+    httpd_register_uri_handler(server, &(httpd_uri_t){
+        .uri = "/events",
+        .method = HTTP_GET,
+        .handler = events_handler});
+}
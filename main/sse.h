@@ -0,0 +1,12 @@
+#ifndef SSE_H
+#define SSE_H
+
+#include "esp_http_server.h"
+
+#define SSE_MAX_CLIENTS 4           // Conexões /events abertas ao mesmo tempo (uma por celular)
+#define SSE_TICK_MS 1000            // Maior intervalo entre duas passadas da task do SSE
+
+void sse_start(httpd_handle_t server);
+void sse_notify(void);
+
+#endif // SSE_H
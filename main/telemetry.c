@@ -0,0 +1,73 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "telemetry.h"
+
+// Seqlock: o contador fica ímpar enquanto o escritor copia a foto. O escritor (um só, a task
+// da UART) nunca espera; o leitor repete a cópia se o contador mudou no meio dela.
+static atomic_uint telemetry_seq;
+static Telemetry telemetry_data;
+
+// Publica uma nova foto; só pode ser chamada de uma task
+void telemetry_publish(const Telemetry *snapshot){
+    unsigned seq = atomic_load_explicit(&telemetry_seq, memory_order_relaxed);
+
+    atomic_store_explicit(&telemetry_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(&telemetry_data, snapshot, sizeof(telemetry_data));
+    telemetry_data.version = (seq + 2) / 2;
+
+    atomic_store_explicit(&telemetry_seq, seq + 2, memory_order_release);
+}
+
+// Copia a foto mais recente. Não bloqueia o escritor: se ele publicar durante a cópia, lê de novo.
+void telemetry_read(Telemetry *out){
+    unsigned before, after;
+
+    do {
+        before = atomic_load_explicit(&telemetry_seq, memory_order_acquire);
+        memcpy(out, &telemetry_data, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&telemetry_seq, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
+
+// Versão da foto atual, para saber se mudou sem copiá-la
+uint32_t telemetry_version(void){
+    return atomic_load_explicit(&telemetry_seq, memory_order_acquire) / 2;
+}
+
+// Serializa a foto no formato binário; retorna o tamanho, ou 0 se out não comporta.
+// O ESP32 é little-endian, então os campos vão direto da struct.
+size_t telemetry_pack(const Telemetry *t, uint8_t *out, size_t size){
+    float ckmh = t->speed_kmh * 100.0f;
+    TelemetryBin bin = {
+        .format = TELEMETRY_BIN_FORMAT,
+        .flags = (t->valid ? TELEMETRY_BIN_VALID : 0) | (t->lap_started ? TELEMETRY_BIN_STARTED : 0),
+        .current_count = t->current.sector_count,
+        .last_count = t->last.sector_count,
+        .version = t->version,
+        .utc_ms = t->utc_ms,
+        .lat_e7 = t->lat_e7,
+        .lon_e7 = t->lon_e7,
+        .speed_ckmh = ckmh <= 0 ? 0 : ckmh >= 65535.0f ? 65535 : (uint16_t)(ckmh + 0.5f),
+        .live_ms = t->lap_started ? (int32_t)(t->live_us / 1000) : -1,
+        .last_lap_ms = t->last.lap_us ? (int32_t)(t->last.lap_us / 1000) : -1,
+    };
+    size_t len = sizeof(bin) + ((size_t)bin.current_count + bin.last_count) * sizeof(uint32_t);
+    if (len > size) {
+        return 0;
+    }
+
+    memcpy(out, &bin, sizeof(bin));
+    uint8_t *p = out + sizeof(bin);
+    for (int i = 0; i < bin.current_count; i++, p += sizeof(uint32_t)) {
+        uint32_t ms = (uint32_t)(t->current.sector_us[i] / 1000);
+        memcpy(p, &ms, sizeof(ms));
+    }
+    for (int i = 0; i < bin.last_count; i++, p += sizeof(uint32_t)) {
+        uint32_t ms = (uint32_t)(t->last.sector_us[i] / 1000);
+        memcpy(p, &ms, sizeof(ms));
+    }
+    return len;
+}
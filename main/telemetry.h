@@ -0,0 +1,52 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lap_engine.h"
+
+// Foto do estado ao vivo da cronometragem, publicada pela task da UART a cada fix e lida
+// pelos handlers HTTP. Sempre copiada inteira: o leitor nunca vê metade de uma atualização.
+typedef struct {
+    uint32_t version;           // Publicações até aqui (0 = nada publicado ainda)
+    bool valid;                 // O último fix tinha posição
+    uint32_t utc_ms;            // Horário GNSS do último fix, em ms do dia (UINT32_MAX = sem horário)
+    float speed_kmh;
+    int32_t lat_e7, lon_e7;
+    bool lap_started;           // Já passou pela linha de chegada
+    int64_t live_us;            // Tempo desde o último checkpoint
+    LapResult current;          // Setores da volta em andamento
+    LapResult last;             // Última volta completa (lap_us = 0 se ainda não houve)
+} Telemetry;
+
+#define TELEMETRY_BIN_FORMAT 1
+#define TELEMETRY_BIN_VALID 0x01        // flags: o último fix tinha posição
+#define TELEMETRY_BIN_STARTED 0x02      // flags: já passou pela linha de chegada
+#define TELEMETRY_BIN_MAX (sizeof(TelemetryBin) + 2 * TRACK_MAX_GATES * sizeof(uint32_t))
+
+// Formato binário da foto (/data.bin), little-endian. Depois do cabeçalho vêm current_count
+// tempos de setor da volta em andamento e last_count da última volta, em uint32 ms.
+typedef struct __attribute__((packed)) {
+    uint8_t format;             // TELEMETRY_BIN_FORMAT
+    uint8_t flags;              // TELEMETRY_BIN_*
+    uint8_t current_count;      // Setores da volta em andamento
+    uint8_t last_count;         // Setores da última volta
+    uint32_t version;
+    uint32_t utc_ms;            // Horário GNSS do fix, ms do dia (UINT32_MAX = sem horário)
+    int32_t lat_e7;             // Posição em 1e-7 grau
+    int32_t lon_e7;
+    uint16_t speed_ckmh;        // Velocidade em 0,01 km/h
+    uint16_t reserved;
+    int32_t live_ms;            // Tempo ao vivo (-1 antes da primeira passagem pela chegada)
+    int32_t last_lap_ms;        // Última volta (-1 se ainda não houve)
+} TelemetryBin;
+
+_Static_assert(sizeof(TelemetryBin) == 32, "TelemetryBin deve ter 32 bytes");
+
+void telemetry_publish(const Telemetry *snapshot);
+void telemetry_read(Telemetry *out);
+uint32_t telemetry_version(void);
+size_t telemetry_pack(const Telemetry *t, uint8_t *out, size_t size);
+
+#endif // TELEMETRY_H
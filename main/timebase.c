@@ -0,0 +1,142 @@
+#include "timebase.h"
+
+#define MS_PER_DAY 86400000
+#define MAX_GAP_MS 60000        // Intervalo sem fixes acima disso recomeça o modelo
+
+// Diferença a - b entre dois horários em ms do dia, considerando a virada da meia-noite
+static int32_t utc_diff_ms(uint32_t a, uint32_t b){
+    int32_t d = (int32_t)a - (int32_t)b;
+    if (d >= MS_PER_DAY / 2) {
+        d -= MS_PER_DAY;
+    } else if (d < -MS_PER_DAY / 2) {
+        d += MS_PER_DAY;
+    }
+    return d;
+}
+
+void timebase_init(Timebase *tb){
+    *tb = (Timebase){ 0 };
+}
+
+static void timebase_set_ref(Timebase *tb, uint32_t utc_ms, int64_t local_us){
+    tb->ref_utc_ms = utc_ms;
+    tb->ref_local_us = local_us;
+    tb->locked = true;
+}
+
+// Instante do esp_timer correspondente a um horário GNSS, pelo modelo atual
+int64_t timebase_to_local(const Timebase *tb, uint32_t utc_ms){
+    int64_t dt_us = (int64_t)utc_diff_ms(utc_ms, tb->ref_utc_ms) * 1000;
+    return tb->ref_local_us + dt_us + dt_us * tb->drift_ppb / 1000000000;
+}
+
+// Registra a borda de subida do PPS (esp_timer lido na ISR). O segundo GNSS a que ela
+// pertence só é conhecido quando chega o fix seguinte.
+void timebase_pps_edge(Timebase *tb, int64_t edge_us){
+    tb->edges++;
+
+    // Pulsos a menos de 0,9 s do anterior são ruído na linha
+    if (tb->prev_edge_us && edge_us - tb->prev_edge_us < 900000) {
+        tb->edges_rejected++;
+        return;
+    }
+    tb->prev_edge_us = edge_us;
+    tb->edge_us = edge_us;
+    tb->edge_pending = true;
+}
+
+// Um pulso associado ao início do segundo sec_ms: vira o novo ponto de referência e corrige
+// o desvio de frequência pelo erro da previsão
+static void pps_update(Timebase *tb, uint32_t sec_ms, int64_t edge_us){
+    tb->edges_matched++;
+
+    if (tb->locked && tb->pps) {
+        int32_t dt_ms = utc_diff_ms(sec_ms, tb->ref_utc_ms);
+        int64_t residual = edge_us - timebase_to_local(tb, sec_ms);
+
+        if (dt_ms <= 0 || residual > TIMEBASE_PPS_MAX_RESIDUAL_US || residual < -TIMEBASE_PPS_MAX_RESIDUAL_US) {
+            // Salto de tempo (ou pulso do segundo errado): recomeça deste pulso
+            tb->resets++;
+            tb->drift_ppb = 0;
+        } else if (dt_ms <= MAX_GAP_MS) {
+            // Desvio medido no intervalo entre os pulsos, suavizado em 1/8 por pulso
+            int64_t dt_us = (int64_t)dt_ms * 1000;
+            int64_t measured_ppb = (edge_us - tb->ref_local_us - dt_us) * 1000000000 / dt_us;
+            tb->drift_ppb += (int32_t)((measured_ppb - tb->drift_ppb) / 8);
+        }
+    }
+
+    tb->pps = true;
+    timebase_set_ref(tb, sec_ms, edge_us);
+}
+
+// Sem PPS: o modelo segue o fix que chega mais cedo. Um fix adiantado em relação ao modelo
+// vira a nova referência; um atrasado só puxa o modelo até TIMEBASE_ENVELOPE_PPM, o bastante
+// para acompanhar o cristal sem herdar o atraso de fila e de escalonamento.
+static void envelope_update(Timebase *tb, uint32_t utc_ms, int64_t arrival_us){
+    if (!tb->locked) {
+        timebase_set_ref(tb, utc_ms, arrival_us);
+        return;
+    }
+
+    int32_t dt_ms = utc_diff_ms(utc_ms, tb->ref_utc_ms);
+    if (dt_ms <= 0) {
+        return; // Fix repetido ou fora de ordem
+    }
+    if (dt_ms > MAX_GAP_MS) {
+        tb->resets++;
+        timebase_set_ref(tb, utc_ms, arrival_us);
+        return;
+    }
+
+    int64_t predicted = timebase_to_local(tb, utc_ms);
+    int64_t delay = arrival_us - predicted;
+    int64_t creep = (int64_t)dt_ms * TIMEBASE_ENVELOPE_PPM / 1000;
+    if (delay < 0) {
+        timebase_set_ref(tb, utc_ms, arrival_us);
+    } else {
+        timebase_set_ref(tb, utc_ms, predicted + (delay < creep ? delay : creep));
+    }
+}
+
+// Atualiza o modelo com um fix: horário GNSS da medição e instante de chegada no esp_timer
+void timebase_fix(Timebase *tb, uint32_t utc_ms, int64_t arrival_us){
+    if (utc_ms == UINT32_MAX) {
+        return; // Fix sem horário
+    }
+
+    // O pulso marca o início do segundo, então o fix chega entre a fração de segundo e a
+    // fração mais TIMEBASE_MAX_FIX_DELAY_US depois dele. Isso descarta o pulso do segundo
+    // seguinte, que pode chegar antes dos últimos fixes do segundo atual.
+    if (tb->edge_pending) {
+        int64_t since_edge = arrival_us - tb->edge_us - (int64_t)(utc_ms % 1000) * 1000;
+        if (since_edge >= 0 && since_edge < TIMEBASE_MAX_FIX_DELAY_US) {
+            tb->edge_pending = false;
+            pps_update(tb, utc_ms - utc_ms % 1000, tb->edge_us);
+            return;
+        }
+        if (arrival_us - tb->edge_us > 1000000 + TIMEBASE_MAX_FIX_DELAY_US) {
+            tb->edge_pending = false; // Nenhum fix correspondeu a este pulso
+        }
+    }
+
+    if (tb->pps && utc_diff_ms(utc_ms, tb->ref_utc_ms) > TIMEBASE_PPS_TIMEOUT_MS) {
+        tb->pps = false; // O PPS parou: segue pela chegada a partir do modelo atual
+    }
+    if (!tb->pps) {
+        envelope_update(tb, utc_ms, arrival_us);
+    }
+}
+
+// Converte o horário do fix (ms do dia) em microssegundos contínuos, sem o salto de 24 h na
+// meia-noite. A origem é arbitrária: só as diferenças entre fixes têm significado.
+int64_t gnss_clock_us(GnssClock *clk, uint32_t utc_ms){
+    if (!clk->started) {
+        clk->started = true;
+        clk->time_ms = utc_ms;
+    } else {
+        clk->time_ms += utc_diff_ms(utc_ms, clk->last_utc_ms);
+    }
+    clk->last_utc_ms = utc_ms;
+    return clk->time_ms * 1000;
+}
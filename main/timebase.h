@@ -0,0 +1,48 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TIMEBASE_MAX_FIX_DELAY_US 500000    // Maior atraso aceito entre a medição e a chegada do fix
+#define TIMEBASE_PPS_TIMEOUT_MS 3000        // Sem PPS por mais que isso, volta ao modelo pela chegada
+#define TIMEBASE_PPS_MAX_RESIDUAL_US 1000   // Pulso fora do previsto por mais que isso reinicia o modelo
+#define TIMEBASE_ENVELOPE_PPM 50            // Quanto o modelo sem PPS pode adiantar por segundo
+
+// Relação entre o horário GNSS (ms do dia) e o esp_timer (us): um ponto de referência e o
+// desvio de frequência do cristal local. Com PPS, cada pulso vira um novo ponto exato e
+// atualiza o desvio; sem PPS, o modelo acompanha o menor atraso de chegada dos fixes, que é
+// o atraso fixo do receptor e da UART sem o jitter de fila e de escalonamento.
+typedef struct {
+    bool locked;                // Modelo válido
+    bool pps;                   // Modelo atual vem do PPS
+    uint32_t ref_utc_ms;        // Horário GNSS do ponto de referência
+    int64_t ref_local_us;       // esp_timer no ponto de referência
+    int32_t drift_ppb;          // Desvio do esp_timer em relação ao GNSS (bilionésimos)
+
+    bool edge_pending;          // Há um pulso ainda não associado a um segundo GNSS
+    int64_t edge_us;            // esp_timer do último pulso
+    int64_t prev_edge_us;       // esp_timer do pulso anterior, para filtrar ruído
+
+    // Contadores para diagnóstico
+    uint32_t edges;             // Pulsos recebidos
+    uint32_t edges_matched;     // Pulsos associados a um segundo GNSS
+    uint32_t edges_rejected;    // Pulsos descartados como ruído
+    uint32_t resets;            // Modelo reiniciado por salto de tempo
+} Timebase;
+
+// Horário GNSS contínuo: os ms do dia desdobrados na virada da meia-noite
+typedef struct {
+    bool started;
+    uint32_t last_utc_ms;       // Último horário recebido, em ms do dia
+    int64_t time_ms;            // O mesmo horário, contado desde o primeiro fix da sessão
+} GnssClock;
+
+void timebase_init(Timebase *tb);
+void timebase_pps_edge(Timebase *tb, int64_t edge_us);
+void timebase_fix(Timebase *tb, uint32_t utc_ms, int64_t arrival_us);
+int64_t timebase_to_local(const Timebase *tb, uint32_t utc_ms);
+
+int64_t gnss_clock_us(GnssClock *clk, uint32_t utc_ms);
+
+#endif // TIMEBASE_H
@@ -0,0 +1,168 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "track_upload.h"
+
+#define LAT_LIMIT 90.0
+#define LON_LIMIT 180.0
+
+// Coordenadas recebidas na linha atual de "linhas"
+#define GATE_KEY_LAT    0x01
+#define GATE_KEY_LON    0x02
+#define GATE_KEY_LAT_B  0x04
+#define GATE_KEY_LON_B  0x08
+
+// Campos do formulário do portal: linha e coordenada de cada um
+typedef struct {
+    const char *key;
+    uint8_t gate;
+    bool is_lat;
+} FormField;
+
+static const FormField FORM_FIELDS[] = {
+    { "lat_start", 0, true },
+    { "lon_start", 0, false },
+    { "lin_lat", 0, true },     // Nomes antigos da linha de chegada
+    { "lin_long", 0, false },
+    { "pos1_lat", 1, true },
+    { "pos1_long", 1, false },
+    { "pos2_lat", 2, true },
+    { "pos2_long", 2, false },
+};
+
+// Altera a latitude ou longitude de uma linha definida por ponto, estendendo a pista se preciso
+static void track_set_point(TrackDef *track, int index, bool is_lat, double value){
+    if (track->gate_count <= index) {
+        track->gate_count = index + 1;
+    }
+    track->gates[index].has_line = false;
+    if (is_lat) {
+        track->gates[index].lat = value;
+    } else {
+        track->gates[index].lon = value;
+    }
+}
+
+static bool level_is(const JsonStream *js, int level, bool array, const char *key){
+    return js->level[level].array == array && (!key || strcmp(js->level[level].key, key) == 0);
+}
+
+// Converte o valor de uma coordenada. Texto vazio, null ou booleano: o campo fica como está.
+// Fora de ±limit (ou nan) o documento todo é inválido.
+static bool coordinate(TrackUpload *u, JsonValueType type, const char *text, double limit, double *value){
+    char *end;
+
+    if ((type != JSON_NUMBER && type != JSON_STRING) || text[0] == '\0') {
+        return false;
+    }
+    *value = strtod(text, &end);
+    if (*end != '\0' || !(fabs(*value) <= limit)) {
+        u->invalid = true;
+        return false;
+    }
+    return true;
+}
+
+// Uma coordenada de "linhas": level[1].index é a linha, level[2].key o campo
+static void gate_value(TrackUpload *u, const JsonStream *js, JsonValueType type, const char *text){
+    uint32_t index = js->level[1].index;
+    const char *key = js->level[2].key;
+    double value;
+
+    if (index >= TRACK_MAX_GATES) {
+        u->too_many = true;
+        return;
+    }
+    TrackGate *gate = &u->track.gates[index];
+    if (u->gate_index != (int16_t)index) {
+        *gate = (TrackGate){ 0 };
+        u->gate_index = (int16_t)index;
+        u->gate_keys = 0;
+        u->gates_seen = (uint8_t)(index + 1);
+    }
+
+    if (strcmp(key, "lat") == 0 && coordinate(u, type, text, LAT_LIMIT, &value)) {
+        gate->lat = value;
+        u->gate_keys |= GATE_KEY_LAT;
+    } else if (strcmp(key, "lon") == 0 && coordinate(u, type, text, LON_LIMIT, &value)) {
+        gate->lon = value;
+        u->gate_keys |= GATE_KEY_LON;
+    } else if (strcmp(key, "lat_b") == 0 && coordinate(u, type, text, LAT_LIMIT, &value)) {
+        gate->lat_b = value;
+        u->gate_keys |= GATE_KEY_LAT_B;
+    } else if (strcmp(key, "lon_b") == 0 && coordinate(u, type, text, LON_LIMIT, &value)) {
+        gate->lon_b = value;
+        u->gate_keys |= GATE_KEY_LON_B;
+    }
+}
+
+// Fim de um item de "linhas": a linha precisa do centro completo, e a extremidade B vem inteira
+// ou não vem. Uma linha sem nenhuma coordenada ({}) nunca passou por gate_value.
+static void gate_end(TrackUpload *u, const JsonStream *js){
+    uint8_t line_keys = u->gate_keys & (GATE_KEY_LAT_B | GATE_KEY_LON_B);
+
+    if (js->level[1].index >= TRACK_MAX_GATES) {
+        u->too_many = true;
+    } else if (u->gate_index != (int16_t)js->level[1].index ||
+               (u->gate_keys & (GATE_KEY_LAT | GATE_KEY_LON)) != (GATE_KEY_LAT | GATE_KEY_LON) ||
+               (line_keys != 0 && line_keys != (GATE_KEY_LAT_B | GATE_KEY_LON_B))) {
+        u->invalid = true;
+    } else {
+        u->track.gates[js->level[1].index].has_line = line_keys != 0;
+    }
+}
+
+static void on_value(const JsonStream *js, JsonValueType type, const char *text, void *ctx){
+    TrackUpload *u = (TrackUpload *)ctx;
+    double value;
+
+    if (type == JSON_END) {
+        if (js->depth == 3 && level_is(js, 0, false, "linhas") && level_is(js, 1, true, NULL) &&
+            level_is(js, 2, false, NULL)) {
+            gate_end(u, js);
+        }
+    } else if (js->depth == 1 && level_is(js, 0, false, NULL)) {
+        for (size_t i = 0; i < sizeof(FORM_FIELDS) / sizeof(FORM_FIELDS[0]); i++) {
+            if (strcmp(js->level[0].key, FORM_FIELDS[i].key) == 0 &&
+                coordinate(u, type, text, FORM_FIELDS[i].is_lat ? LAT_LIMIT : LON_LIMIT, &value)) {
+                track_set_point(&u->track, FORM_FIELDS[i].gate, FORM_FIELDS[i].is_lat, value);
+            }
+        }
+    } else if (js->depth == 3 && level_is(js, 0, false, "linhas") && level_is(js, 1, true, NULL) &&
+               level_is(js, 2, false, NULL)) {
+        gate_value(u, js, type, text);
+    } else if (js->depth == 2 && level_is(js, 0, false, "linhas") && level_is(js, 1, true, NULL)) {
+        u->invalid = true;      // Item de "linhas" que não é objeto
+    } else if (js->depth == 3 && level_is(js, 0, false, "referencia") && level_is(js, 1, true, NULL) &&
+               level_is(js, 2, true, NULL) && js->level[2].index == 0) {
+        u->points++;
+    }
+}
+
+// Começa uma nova recepção a partir da pista base (a atual, para alterar só alguns campos)
+void track_upload_init(TrackUpload *u, const TrackDef *base){
+    json_stream_init(&u->json, on_value, u);
+    u->track = *base;
+    u->gates_seen = 0;
+    u->gate_index = -1;
+    u->gate_keys = 0;
+    u->too_many = false;
+    u->invalid = false;
+    u->points = 0;
+}
+
+// Um pedaço do corpo; false se o JSON ou os valores são inválidos
+bool track_upload_feed(TrackUpload *u, const char *data, size_t len){
+    return json_stream_feed(&u->json, data, len) && !u->too_many && !u->invalid;
+}
+
+// Fim do corpo: confere o documento e aplica a lista de linhas, se veio
+bool track_upload_finish(TrackUpload *u){
+    if (!json_stream_finish(&u->json) || u->too_many || u->invalid) {
+        return false;
+    }
+    if (u->gates_seen > 0) {
+        u->track.gate_count = u->gates_seen;
+    }
+    return true;
+}
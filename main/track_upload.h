@@ -0,0 +1,32 @@
+#ifndef TRACK_UPLOAD_H
+#define TRACK_UPLOAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "json_stream.h"
+#include "lap_engine.h"
+
+// Recebe uma definição de pista em JSON, em pedaços, com memória fixa. Aceita os campos do
+// portal (lat_start, lon_start, pos1_lat, ... como texto ou número) e a pista completa:
+//   { "linhas": [ { "lat": .., "lon": .. }, { "lat": .., "lon": .., "lat_b": .., "lon_b": .. } ],
+//     "referencia": [ [lat, lon, ms], ... ] }
+// "linhas" substitui todas as linhas, a primeira é a chegada. Cada linha precisa de lat e lon, e
+// lat_b e lon_b vêm as duas ou nenhuma; latitudes ficam em ±90 e longitudes em ±180. Os pontos da volta de referência
+// são conferidos e contados, sem ocupar memória; outras chaves são ignoradas.
+typedef struct {
+    JsonStream json;
+    TrackDef track;
+    uint8_t gates_seen;         // Linhas recebidas em "linhas"
+    int16_t gate_index;         // Linha de "linhas" sendo preenchida (-1 = nenhuma)
+    uint8_t gate_keys;          // Coordenadas já recebidas nessa linha (GATE_KEY_*)
+    bool too_many;              // "linhas" com mais que TRACK_MAX_GATES
+    bool invalid;               // Coordenada que não é número ou fora da faixa, ou linha incompleta
+    uint32_t points;            // Pontos da volta de referência
+} TrackUpload;
+
+void track_upload_init(TrackUpload *u, const TrackDef *base);
+bool track_upload_feed(TrackUpload *u, const char *data, size_t len);
+bool track_upload_finish(TrackUpload *u);
+
+#endif // TRACK_UPLOAD_H
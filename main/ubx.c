@@ -0,0 +1,214 @@
+#include <string.h>
+#include "ubx.h"
+
+#define MS_PER_DAY 86400000
+
+// Etapas da leitura de um quadro
+enum {
+    UBX_WAIT_SYNC_1,
+    UBX_WAIT_SYNC_2,
+    UBX_READ_CLASS,
+    UBX_READ_ID,
+    UBX_READ_LEN_1,
+    UBX_READ_LEN_2,
+    UBX_READ_PAYLOAD,
+    UBX_READ_CK_A,
+    UBX_READ_CK_B,
+};
+
+void ubx_parser_init(UbxParser *p, gnss_fix_cb callback, void *ctx){
+    memset(p, 0, sizeof(*p));
+    p->callback = callback;
+    p->ctx = ctx;
+}
+
+// Volta a procurar a sincronia, mantendo os contadores (usado após perda de dados na UART)
+void ubx_parser_reset(UbxParser *p){
+    p->state = UBX_WAIT_SYNC_1;
+}
+
+// Converte o payload de um UBX-NAV-PVT em GnssFix; só aritmética inteira e conversões de escala
+bool ubx_decode_nav_pvt(const uint8_t *payload, size_t len, GnssFix *fix){
+    UbxNavPvt pvt;
+
+    if (len != UBX_NAV_PVT_LEN) {
+        return false;
+    }
+    memcpy(&pvt, payload, sizeof(pvt));
+    memset(fix, 0, sizeof(*fix));
+
+    fix->itow_ms = pvt.itow;
+    fix->fields = GNSS_HAS_TOW | GNSS_HAS_QUALITY | GNSS_HAS_DOP | GNSS_HAS_ERROR;
+
+    // Hora UTC com a fração em ns (que pode ser negativa), em milissegundos do dia
+    int32_t utc_ms = ((int32_t)pvt.hour * 3600 + pvt.min * 60 + pvt.sec) * 1000 + pvt.nano / 1000000;
+    if (utc_ms < 0) {
+        utc_ms += MS_PER_DAY;
+    } else if (utc_ms >= MS_PER_DAY) {
+        utc_ms -= MS_PER_DAY;
+    }
+    fix->utc_ms = (pvt.valid & 0x02) ? (uint32_t)utc_ms : UINT32_MAX;
+
+    if (pvt.valid & 0x01) {
+        fix->day = pvt.day;
+        fix->month = pvt.month;
+        fix->year = pvt.year;
+        fix->fields |= GNSS_HAS_DATE;
+    }
+
+    // Tipo de fix e qualidade no formato das sentenças GSA e GGA
+    bool fix_ok = (pvt.flags & 0x01) && pvt.fix_type >= 2 && pvt.fix_type <= 4;
+    fix->fix_type = !fix_ok ? 1 : (pvt.fix_type == 2 ? 2 : 3);
+    if (!fix_ok) {
+        fix->quality = 0;
+    } else if ((pvt.flags >> 6) == 2) {
+        fix->quality = 4;       // RTK fixo
+    } else if ((pvt.flags >> 6) == 1) {
+        fix->quality = 5;       // RTK flutuante
+    } else {
+        fix->quality = (pvt.flags & 0x02) ? 2 : 1;
+    }
+    fix->satellites = pvt.num_sv;
+    fix->pdop = pvt.p_dop * 0.01f;
+    fix->lat_err_m = fix->lon_err_m = pvt.h_acc * 0.001f;
+
+    if (fix_ok) {
+        fix->lat_e7 = pvt.lat;
+        fix->lon_e7 = pvt.lon;
+        fix->altitude_m = pvt.h_msl * 0.001f;
+        fix->speed_kmh = pvt.g_speed * 0.0036f;
+        fix->course_deg = pvt.head_mot * 1e-5f;
+        fix->fields |= GNSS_HAS_POSITION | GNSS_HAS_ALTITUDE | GNSS_HAS_SPEED | GNSS_HAS_COURSE;
+        fix->valid = true;
+    }
+    return true;
+}
+
+// Checksum Fletcher de 8 bits sobre classe, id, tamanho e payload
+static inline void ubx_checksum(UbxParser *p, uint8_t byte){
+    p->ck_a += byte;
+    p->ck_b += p->ck_a;
+}
+
+// Monta um quadro UBX completo (sincronia, cabeçalho, payload e checksum) em out.
+// Retorna o tamanho do quadro, ou 0 se não couber.
+size_t ubx_build_frame(uint8_t *out, size_t cap, uint8_t msg_class, uint8_t msg_id,
+                       const uint8_t *payload, uint16_t len){
+    if (cap < (size_t)len + 8) {
+        return 0;
+    }
+    out[0] = UBX_SYNC_1;
+    out[1] = UBX_SYNC_2;
+    out[2] = msg_class;
+    out[3] = msg_id;
+    out[4] = len & 0xFF;
+    out[5] = len >> 8;
+    if (len) {
+        memcpy(out + 6, payload, len);
+    }
+
+    uint8_t ck_a = 0, ck_b = 0;
+    for (size_t i = 2; i < (size_t)len + 6; i++) {
+        ck_a += out[i];
+        ck_b += ck_a;
+    }
+    out[len + 6] = ck_a;
+    out[len + 7] = ck_b;
+    return (size_t)len + 8;
+}
+
+// Trata um quadro com checksum correto. Dos maiores que UBX_MAX_PAYLOAD só ficam a classe e o id.
+static void ubx_frame_done(UbxParser *p, int64_t arrival_us){
+    GnssFix fix;
+
+    p->frames++;
+    p->last_class = p->msg_class;
+    p->last_id = p->msg_id;
+    if (p->callback && p->len <= UBX_MAX_PAYLOAD && p->msg_class == UBX_CLASS_NAV &&
+        p->msg_id == UBX_ID_NAV_PVT && ubx_decode_nav_pvt(p->payload, p->len, &fix)) {
+        fix.local_us = fix.complete_us = arrival_us;
+        p->callback(&fix, p->ctx);
+    }
+}
+
+// Processa os bytes recebidos; cada NAV-PVT completo vai ao callback com local_us = arrival_us.
+// Retorna a quantidade de quadros válidos encontrados.
+size_t ubx_parser_feed(UbxParser *p, const uint8_t *data, size_t len, int64_t arrival_us){
+    size_t frames = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t byte = data[i];
+
+        switch (p->state) {
+        case UBX_WAIT_SYNC_1:
+            if (byte == UBX_SYNC_1) {
+                p->state = UBX_WAIT_SYNC_2;
+            } else {
+                p->skipped++;
+            }
+            break;
+        case UBX_WAIT_SYNC_2:
+            if (byte == UBX_SYNC_2) {
+                p->state = UBX_READ_CLASS;
+                p->ck_a = p->ck_b = 0;
+            } else {
+                p->skipped++;
+                p->state = (byte == UBX_SYNC_1) ? UBX_WAIT_SYNC_2 : UBX_WAIT_SYNC_1;
+            }
+            break;
+        case UBX_READ_CLASS:
+            ubx_checksum(p, byte);
+            p->msg_class = byte;
+            p->state = UBX_READ_ID;
+            break;
+        case UBX_READ_ID:
+            ubx_checksum(p, byte);
+            p->msg_id = byte;
+            p->state = UBX_READ_LEN_1;
+            break;
+        case UBX_READ_LEN_1:
+            ubx_checksum(p, byte);
+            p->len = byte;
+            p->state = UBX_READ_LEN_2;
+            break;
+        case UBX_READ_LEN_2:
+            ubx_checksum(p, byte);
+            p->len |= (uint16_t)byte << 8;
+            p->pos = 0;
+            if (p->len > UBX_SANE_PAYLOAD) {
+                // 0xB5 0x62 no meio de outros dados: volta a procurar a sincronia
+                p->skipped += 6;
+                p->state = UBX_WAIT_SYNC_1;
+                break;
+            }
+            if (p->len > UBX_MAX_PAYLOAD) {
+                p->oversized++;
+            }
+            p->state = p->len ? UBX_READ_PAYLOAD : UBX_READ_CK_A;
+            break;
+        case UBX_READ_PAYLOAD:
+            ubx_checksum(p, byte);
+            if (p->pos < UBX_MAX_PAYLOAD) {
+                p->payload[p->pos] = byte;
+            }
+            if (++p->pos == p->len) {
+                p->state = UBX_READ_CK_A;
+            }
+            break;
+        case UBX_READ_CK_A:
+            p->rx_ck_a = byte;
+            p->state = UBX_READ_CK_B;
+            break;
+        case UBX_READ_CK_B:
+            p->state = UBX_WAIT_SYNC_1;
+            if (p->rx_ck_a != p->ck_a || byte != p->ck_b) {
+                p->bad_checksum++;
+            } else {
+                ubx_frame_done(p, arrival_us);
+                frames++;
+            }
+            break;
+        }
+    }
+    return frames;
+}
@@ -0,0 +1,97 @@
+#ifndef UBX_H
+#define UBX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "gnss_fix.h"
+
+// Protocolo binário UBX dos receptores u-blox:
+// 0xB5 0x62, classe, id, tamanho (2 bytes, little-endian), payload, CK_A, CK_B
+#define UBX_SYNC_1          0xB5
+#define UBX_SYNC_2          0x62
+
+#define UBX_CLASS_NAV       0x01
+#define UBX_ID_NAV_PVT      0x07
+#define UBX_CLASS_CFG       0x06
+#define UBX_ID_CFG_PRT      0x00
+#define UBX_ID_CFG_MSG      0x01
+#define UBX_ID_CFG_RATE     0x08
+#define UBX_ID_CFG_VALSET   0x8A
+#define UBX_CLASS_MON       0x0A
+#define UBX_ID_MON_VER      0x04
+#define UBX_CLASS_NMEA      0xF0    // Classe usada no CFG-MSG para as sentenças NMEA
+
+#define UBX_NAV_PVT_LEN     92
+#define UBX_MAX_PAYLOAD     100     // Mensagens maiores são puladas sem copiar o payload
+#define UBX_SANE_PAYLOAD    2048    // Tamanho acima disso indica sincronia falsa
+
+// Payload do UBX-NAV-PVT, na ordem e no tamanho do protocolo (little-endian, como a ESP32)
+typedef struct __attribute__((packed)) {
+    uint32_t itow;          // Tempo da semana GPS em ms
+    uint16_t year;          // Data e hora UTC
+    uint8_t month, day;
+    uint8_t hour, min, sec;
+    uint8_t valid;          // bit0 data válida, bit1 hora válida
+    uint32_t t_acc;         // Precisão da hora em ns
+    int32_t nano;           // Fração de segundo em ns (-1e9..1e9)
+    uint8_t fix_type;       // 0 sem fix, 1 DR, 2 2D, 3 3D, 4 GNSS+DR, 5 só tempo
+    uint8_t flags;          // bit0 gnssFixOK, bit1 diffSoln, bits 6-7 carrSoln
+    uint8_t flags2;
+    uint8_t num_sv;         // Satélites em uso
+    int32_t lon;            // 1e-7 grau
+    int32_t lat;            // 1e-7 grau
+    int32_t height;         // Altura elipsoidal em mm
+    int32_t h_msl;          // Altitude acima do nível do mar em mm
+    uint32_t h_acc;         // Precisão horizontal em mm
+    uint32_t v_acc;         // Precisão vertical em mm
+    int32_t vel_n, vel_e, vel_d;    // Velocidade NED em mm/s
+    int32_t g_speed;        // Velocidade no solo em mm/s
+    int32_t head_mot;       // Rumo do movimento em 1e-5 grau
+    uint32_t s_acc;         // Precisão da velocidade em mm/s
+    uint32_t head_acc;      // Precisão do rumo em 1e-5 grau
+    uint16_t p_dop;         // PDOP em 0,01
+    uint8_t flags3;
+    uint8_t reserved[5];
+    int32_t head_veh;       // Rumo do veículo em 1e-5 grau
+    int16_t mag_dec;        // Declinação magnética em 1e-2 grau
+    uint16_t mag_acc;
+} UbxNavPvt;
+
+_Static_assert(sizeof(UbxNavPvt) == UBX_NAV_PVT_LEN, "UBX-NAV-PVT deve ter 92 bytes");
+
+// Leitor de quadros UBX byte a byte: acha a sincronia, confere o checksum Fletcher e entrega
+// cada NAV-PVT já convertido em GnssFix. Bytes fora de quadro (ex.: NMEA misturado) são pulados.
+typedef struct {
+    uint8_t state;          // Etapa do quadro em leitura
+    uint8_t msg_class;
+    uint8_t msg_id;
+    uint16_t len;           // Tamanho do payload do quadro atual
+    uint16_t pos;           // Bytes do payload já lidos
+    uint8_t ck_a, ck_b;     // Checksum acumulado
+    uint8_t rx_ck_a;        // Primeiro byte do checksum recebido
+    uint8_t payload[UBX_MAX_PAYLOAD];
+
+    gnss_fix_cb callback;   // Pode ser NULL: só conta os quadros
+    void *ctx;
+
+    uint8_t last_class;     // Classe e id do último quadro com checksum correto, inclusive
+    uint8_t last_id;        // dos maiores que UBX_MAX_PAYLOAD (ex.: MON-VER)
+
+    // Contadores para diagnóstico
+    uint32_t frames;        // Quadros com checksum correto, de qualquer tamanho
+    uint32_t bad_checksum;  // Quadros descartados por checksum
+    uint32_t oversized;     // Quadros maiores que UBX_MAX_PAYLOAD (payload não guardado)
+    uint32_t skipped;       // Bytes fora de quadro (ou com sincronia falsa)
+} UbxParser;
+
+void ubx_parser_init(UbxParser *p, gnss_fix_cb callback, void *ctx);
+void ubx_parser_reset(UbxParser *p);
+size_t ubx_parser_feed(UbxParser *p, const uint8_t *data, size_t len, int64_t arrival_us);
+
+size_t ubx_build_frame(uint8_t *out, size_t cap, uint8_t msg_class, uint8_t msg_id,
+                       const uint8_t *payload, uint16_t len);
+
+bool ubx_decode_nav_pvt(const uint8_t *payload, size_t len, GnssFix *fix);
+
+#endif // UBX_H
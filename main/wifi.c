@@ -1,3 +1,4 @@
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
@@ -5,17 +6,29 @@
 #include "esp_netif.h"
 #include "esp_event.h"
 #include "esp_http_server.h"
+#include "esp_app_desc.h"
+#include "esp_random.h"
+#include "esp_timer.h"
 #include "lwip/sockets.h"
 #include "lwip/dns.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "wifi.h"
-
-#include "cJSON.h"
+#include "lap_engine.h"
+#include "telemetry.h"
+#include "sse.h"
+#include "ws.h"
+#include "track_upload.h"
 
 
 #ifndef MIN
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 
+#endif
+#ifndef MAX
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
 #endif
 
 #define DNS_PORT 53
@@ -23,14 +36,6 @@
 
 static const char *TAG = "PORTAL_CATIVO";
 
-// Variáveis globais acessadas de main.c
-extern float velocidade;
-extern char tempo_set1[20],  tempo_set2[20],  tempo_set3[20], volta_atual[20], volta_anterior[20];
-
-extern float lat_start, lon_start;
-extern float lat_sec1, lon_sec1;
-extern float lat_sec2, lon_sec2;
-
 
 // Tarefa do servidor DNS para redirecionar consultas
 void dns_server_task(void *pvParameters) {
@@ -57,211 +62,380 @@ void dns_server_task(void *pvParameters) {
     close(sock);
 }
 
+// Página do portal (main/web/index.html), comprimida com gzip na compilação
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[] asm("_binary_index_html_gz_end");
+
+// ETag forte da página: muda só com um novo firmware, derivado do hash do ELF
+static const char *page_etag(void) {
+    static char etag[20];
+
+    if (etag[0] == '\0') {
+        char hash[17];
+        esp_app_get_elf_sha256(hash, sizeof(hash));
+        snprintf(etag, sizeof(etag), "\"%s\"", hash);
+    }
+    return etag;
+}
+
+// O navegador já tem esta versão da página? (If-None-Match pode trazer uma lista de ETags)
+static bool etag_matches(httpd_req_t *req, const char *etag) {
+    char header[128];
+    size_t len = httpd_req_get_hdr_value_len(req, "If-None-Match");
+
+    if (len == 0 || len >= sizeof(header) ||
+        httpd_req_get_hdr_value_str(req, "If-None-Match", header, sizeof(header)) != ESP_OK) {
+        return false;
+    }
+    return strstr(header, etag) != NULL || strcmp(header, "*") == 0;
+}
+
+// Página principal: com cache validado pelo ETag, uma recarga custa só um 304
 esp_err_t get_handler(httpd_req_t *req) {
-    const char *response =
-        "<!DOCTYPE html>"
-        "<html lang=\"pt-BR\">"
-        "<head>"
-        "<meta charset=\"UTF-8\">"
-        "<title>Lap Timer</title>"
-        "<style>"
-        "body { background-color: black; color: white; font-family: Arial, sans-serif; }"
-        "h1 { text-align: center; }"
-        ".container { display: flex; flex-direction: column; align-items: center; margin-top: 20px; }"
-        ".box { border: 1px solid white; padding: 20px; border-radius: 10px; width: 90%; max-width: 300px; margin-bottom: 20px; }"
-        ".box h2 { text-align: center; }"
-        ".box input { width: 80%; margin-bottom: 10px; padding: 5px; }"
-        ".box button { width: 80%; padding: 5px; background-color: white; color: black; border: none; border-radius: 5px; cursor: pointer; }"
-        ".box button:hover { background-color: grey; }"
-        "</style>"
-        "<script>"
-        "function fetchData() {"
-        "  fetch('/data')"
-        "    .then(response => response.json())"
-        "    .then(data => {"
-        "      document.getElementById('velocidade').innerText = data.velocidade ? data.velocidade + ' km/h' : '0 km/h';"
-        "      document.getElementById('volta_atual').innerText = data.volta_atual || 'Sem Dados';"
-        "      document.getElementById('volta_anterior').innerText = data.volta_anterior || 'Sem Dados';"
-        "      document.getElementById('tempo_set1').innerText = data.tempo_set1 || 'Sem Dados';"
-        "      document.getElementById('tempo_set2').innerText = data.tempo_set2 || 'Sem Dados';"
-        "      document.getElementById('tempo_set3').innerText = data.tempo_set3 || 'Sem Dados';"
-        "    });"
-        "}"
-        "function sendData() {"
-        "  const lat_start = document.getElementById('lat_start').value || '0';"
-        "  const lon_start = document.getElementById('lon_start').value || '0';"
-        "  const pos1_lat = document.getElementById('pos1_lat').value || '0';"
-        "  const pos1_long = document.getElementById('pos1_long').value || '0';"
-        "  const pos2_lat = document.getElementById('pos2_lat').value || '0';"
-        "  const pos2_long = document.getElementById('pos2_long').value || '0';"
-        "  fetch('/submit', {"
-        "    method: 'POST',"
-        "    headers: { 'Content-Type': 'application/json' },"
-        "    body: JSON.stringify({"
-        "      lat_start, lon_start,"
-        "      pos1_lat, pos1_long,"
-        "      pos2_lat, pos2_long,"
-        "    })"
-        "  }).then(response => response.text())"
-        "    .then(data => alert('Posições salvas com sucesso!'))"
-        "    .catch(error => alert('Erro ao enviar os dados!'))"
-        "}"
-        "setInterval(fetchData, 500);"
-        "</script>"
-        "</head>"
-        "<body onload=\"fetchData()\">"
-        "<h1>Bem-vindo ao Lap Timer</h1>"
-        "<div class=\"container\">"
-        "<div class=\"box\">"
-        "<h2>Informações</h2>"
-        //Aqui
-        "<p>Velocidade: <span id=\"velocidade\"></span></p>"
-        "<p>Volta Atual: <span id=\"volta_atual\"></span></p>"
-        "<h2>Volta Anterior</h2>"
-        "<p>Volta Anterior: <span id=\"volta_anterior\"></span></p>"
-        "<p>Setor 1: <span id=\"tempo_set1\"></span></p>"
-        "<p>Setor 2: <span id=\"tempo_set2\"></span></p>"
-        "<p>Setor 3: <span id=\"tempo_set3\"></span></p>"        
-        "</div>"
-        "<div class=\"box\">"
-        "<h2>Atualizar Posições</h2>"
-        "<h3>Linha de Chegada/Saída</h3>"
-        "<input id=\"lat_start\" type=\"text\" placeholder=\"Latitude Linha\" />"
-        "<input id=\"lon_start\" type=\"text\" placeholder=\"Longitude Linha\" />"
-        "<h3>Setor 1</h3>"
-        "<input id=\"pos1_lat\" type=\"text\" placeholder=\"Latitude Setor 1\" />"
-        "<input id=\"pos1_long\" type=\"text\" placeholder=\"Longitude Setor 1\" />"
-        "<h3>Setor 2</h3>"
-        "<input id=\"pos2_lat\" type=\"text\" placeholder=\"Latitude Setor 2\" />"
-        "<input id=\"pos2_long\" type=\"text\" placeholder=\"Longitude Setor 2\" />"
-        "<br><br>"
-        "<button onclick=\"sendData()\">Atualizar</button>"
-        "</div>"
-        "</div>"
-        "</body>"
-        "</html>";
-
-    httpd_resp_send(req, response, HTTPD_RESP_USE_STRLEN);
+    const char *etag = page_etag();
+
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    if (etag_matches(req, etag)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        httpd_resp_send(req, NULL, 0);
+        return ESP_OK;
+    }
+
+    httpd_resp_set_type(req, "text/html; charset=utf-8");
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    httpd_resp_send(req, (const char *)index_html_gz_start, index_html_gz_end - index_html_gz_start);
     return ESP_OK;
 }
 
 
 
 
-// Manipulador para retornar dados JSON
-esp_err_t json_handler(httpd_req_t *req) {
-    char response[1024];
-
-    //ESP_LOGI(TAG, "Enviando dados JSON: velocidade=%.0f, volta_atual=%s, volta_anterior=%s", velocidade, volta_atual, volta_anterior);
-
-    
-    snprintf(response, sizeof(response),
-                "{\"velocidade\": %.1f, \"volta_atual\": \"%s\", \"volta_anterior\": \"%s\","
-                "\"tempo_set1\": \"%s\", \"tempo_set2\": \"%s\", \"tempo_set3\": \"%s\","
-                "\"lat_start\": %.8f, \"lon_start\": %.8f,"
-                "\"pos1_lat\": %.8f, \"pos1_long\": %.8f,"
-                "\"pos2_lat\": %.8f, \"pos2_long\": %.8f}",
-                velocidade, volta_atual, volta_anterior,
-                tempo_set1, tempo_set2, tempo_set3,
-                lat_start, lon_start,
-                lat_sec1, lon_sec1,
-                lat_sec2, lon_sec2);
-
-/*
-    snprintf(response, sizeof(response),
-            "{\"velocidade\": %.1f, \"volta_atual\": %s, \"volta_anterior\": %s,"
-            "\"tempo_set1\": %s, \"tempo_set2\": %s, \"tempo_set3\": %s,"
+// Acrescenta ao JSON a lista de tempos de setor de uma volta, em ms; o navegador formata
+static int json_append_sectors(char *buf, size_t size, const char *key, const LapResult *lap) {
+    int len = snprintf(buf, size, "\"%s\": [", key);
+
+    for (int i = 0; i < lap->sector_count && len < (int)size; i++) {
+        len += snprintf(buf + len, size - len, "%s%lld", i ? ", " : "", (long long)(lap->sector_us[i] / 1000));
+    }
+    if (len < (int)size) {
+        len += snprintf(buf + len, size - len, "],");
+    }
+    return len;
+}
+
+// JSON do /data, serializado uma vez por versão da telemetria e compartilhado por todas as
+// requisições. As coordenadas da pista só são refeitas quando a pista muda. Os handlers rodam
+// todos na task do httpd, então o cache não precisa de trava.
+static char data_json[2048];
+static int data_json_len = 0;
+static uint32_t data_version;           // Versão da telemetria serializada em data_json
+static uint32_t data_track;             // Pista serializada em data_json
+static char data_etag[32];
+
+static char track_json[256];            // Coordenadas das linhas, no fim do JSON
+static uint32_t track_json_generation = UINT32_MAX;    // Pistas aplicadas quando track_json foi montado
+static uint32_t boot_id;                // Distingue as versões de um boot das do anterior
+
+static void track_json_serialize(uint32_t generation) {
+    const TrackDef *track = lap_engine_track();
+    double coords[6] = { 0 };
+
+    // Coordenadas das três primeiras linhas, no formato usado pelo portal
+    for (int i = 0; i < 3 && i < track->gate_count; i++) {
+        coords[i * 2] = track->gates[i].lat;
+        coords[i * 2 + 1] = track->gates[i].lon;
+    }
+    // pista_aplicada: pedidos de troca de pista já carregados no motor. O POST responde 202 com o
+    // número do pedido, que está em vigor quando pista_aplicada o alcança.
+    snprintf(track_json, sizeof(track_json),
+            "\"pista_aplicada\": %lu, "
             "\"lat_start\": %.8f, \"lon_start\": %.8f,"
             "\"pos1_lat\": %.8f, \"pos1_long\": %.8f,"
             "\"pos2_lat\": %.8f, \"pos2_long\": %.8f}",
-            velocidade, volta_atual, volta_anterior,
-            tempo_set1, tempo_set2, tempo_set3,
-            lat_start, lon_start,
-            lat_sec1, lon_sec1,
-            lat_sec2, lon_sec2);
-*/
+            (unsigned long)generation,
+            coords[0], coords[1],
+            coords[2], coords[3],
+            coords[4], coords[5]);
+    track_json_generation = generation;
+}
+
+static void data_json_serialize(void) {
+    static Telemetry live;
+    char volta_atual[24] = "null", volta_anterior[24] = "null";
+    int len = 0;
+    uint32_t generation = lap_engine_tracks_applied();
+
+    if (track_json_generation != generation) {
+        track_json_serialize(generation);
+    }
+
+    // Foto consistente do estado ao vivo; a task da UART nunca espera por esta leitura.
+    // Os tempos vão em ms inteiros (null se ainda não houver) e o navegador formata.
+    telemetry_read(&live);
+    if (live.lap_started) {
+        snprintf(volta_atual, sizeof(volta_atual), "%lld", (long long)(live.live_us / 1000));
+    }
+    if (live.last.lap_us) {
+        snprintf(volta_anterior, sizeof(volta_anterior), "%lld", (long long)(live.last.lap_us / 1000));
+    }
+
+    len += snprintf(data_json + len, sizeof(data_json) - len,
+                "{\"versao\": %lu, \"velocidade\": %.1f, \"volta_atual\": %s, \"volta_anterior\": %s,",
+                (unsigned long)live.version, live.speed_kmh, volta_atual, volta_anterior);
+    len += json_append_sectors(data_json + len, sizeof(data_json) - len, "setores", &live.last);
+    len += json_append_sectors(data_json + len, sizeof(data_json) - len, "setores_atual", &live.current);
+    if (len < (int)sizeof(data_json)) {
+        len += snprintf(data_json + len, sizeof(data_json) - len, "%s", track_json);
+    }
+
+    data_json_len = len < (int)sizeof(data_json) ? len : (int)sizeof(data_json) - 1;
+    data_version = live.version;
+    data_track = generation;
+    if (boot_id == 0) {
+        boot_id = esp_random() | 1;
+    }
+    snprintf(data_etag, sizeof(data_etag), "\"%08lx-%lx-%lx\"", (unsigned long)boot_id,
+             (unsigned long)data_track, (unsigned long)data_version);
+}
+
+// Responde com o JSON da versão atual (ou 304, se o navegador já a tem)
+static esp_err_t data_respond(httpd_req_t *req) {
+    if (data_json_len == 0 || telemetry_version() != data_version ||
+        lap_engine_tracks_applied() != data_track) {
+        data_json_serialize();
+    }
+
+    httpd_resp_set_hdr(req, "ETag", data_etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    if (etag_matches(req, data_etag)) {
+        // O navegador já tem esta versão
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
 
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, response, HTTPD_RESP_USE_STRLEN);
+    return httpd_resp_send(req, data_json, data_json_len);
+}
+
+// /data.bin: a mesma foto no formato binário de telemetry_pack, ~60 bytes em vez de ~400
+static uint8_t data_bin[TELEMETRY_BIN_MAX];
+static size_t data_bin_len = 0;
+static uint32_t data_bin_version;
+
+static esp_err_t data_bin_respond(httpd_req_t *req) {
+    static Telemetry live;
+
+    if (data_bin_len == 0 || telemetry_version() != data_bin_version) {
+        telemetry_read(&live);
+        data_bin_len = telemetry_pack(&live, data_bin, sizeof(data_bin));
+        data_bin_version = live.version;
+    }
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, (const char *)data_bin, data_bin_len);
+}
+
+// Long-poll do /data?since=<versao> (e do /data.bin): a requisição fica estacionada (assíncrona, fora da task
+// do httpd) até a telemetria passar dessa versão ou o prazo acabar. O limite vem dos sockets
+// configurados no httpd, descontadas as conexões do SSE e do WebSocket; além dele, responde na
+// hora. Os long-polls têm os próprios timers: não esperam a task do SSE, que pode estar presa
+// num envio para um celular lento.
+#define LONGPOLL_MAX_CLIENTS 4
+#define LONGPOLL_TIMEOUT_US 10000000
+#define LONGPOLL_CHECK_US 1000000       // Verificação dos prazos
+
+typedef struct {
+    httpd_req_t *req;
+    bool bin;               // Resposta em /data.bin
+    uint32_t since;         // Versão que o navegador já tem
+    int64_t deadline_us;    // Responde mesmo sem novidade a partir daqui
+} LongPoll;
+
+static httpd_handle_t http_server = NULL;
+static LongPoll longpolls[LONGPOLL_MAX_CLIENTS];
+static int longpoll_count = 0;
+static int longpoll_limit = 0;
+static atomic_int longpoll_waiting;     // Cópia de longpoll_count para os timers e a task da UART
+static esp_timer_handle_t longpoll_deadline_timer;  // Periódico: prazos
+static esp_timer_handle_t longpoll_wake_timer;      // Disparado a cada fix
+
+// Na task do httpd (httpd_queue_work): responde quem já tem novidade ou estourou o prazo
+static void longpoll_answer(void *arg) {
+    uint32_t version = telemetry_version();
+    int64_t now = esp_timer_get_time();
+
+    for (int i = 0; i < longpoll_count;) {
+        LongPoll *lp = &longpolls[i];
+        if (version == lp->since && now < lp->deadline_us) {
+            i++;
+            continue;
+        }
+        // Se o navegador desistiu, o envio só falha
+        if (lp->bin) {
+            data_bin_respond(lp->req);
+        } else {
+            data_respond(lp->req);
+        }
+        httpd_req_async_handler_complete(lp->req);
+        *lp = longpolls[--longpoll_count];
+    }
+    atomic_store(&longpoll_waiting, longpoll_count);
+}
+
+// Na task do esp_timer, a cada fix e a cada LONGPOLL_CHECK_US: só acorda o httpd se há alguém esperando
+static void longpoll_tick(void *arg) {
+    if (atomic_load(&longpoll_waiting) > 0) {
+        httpd_queue_work(http_server, longpoll_answer, NULL);
+    }
+}
+
+// Atende o /data ou o /data.bin, estacionando a requisição se ela trouxer since
+static esp_err_t data_request(httpd_req_t *req, bool bin) {
+    char query[32], since_text[12];
+    httpd_req_t *async = NULL;
+    esp_err_t (*respond)(httpd_req_t *) = bin ? data_bin_respond : data_respond;
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "since", since_text, sizeof(since_text)) != ESP_OK) {
+        return respond(req);
+    }
+
+    // Só estaciona se o navegador já tem a versão atual e ainda há vaga
+    uint32_t since = strtoul(since_text, NULL, 10);
+    if (since != telemetry_version() || longpoll_count == longpoll_limit ||
+        httpd_req_async_handler_begin(req, &async) != ESP_OK) {
+        return respond(req);
+    }
+    longpolls[longpoll_count++] = (LongPoll){
+        .req = async,
+        .bin = bin,
+        .since = since,
+        .deadline_us = esp_timer_get_time() + LONGPOLL_TIMEOUT_US,
+    };
+    atomic_store(&longpoll_waiting, longpoll_count);
     return ESP_OK;
 }
 
+// Manipulador para retornar dados JSON
+esp_err_t json_handler(httpd_req_t *req) {
+    return data_request(req, false);
+}
+
+// Manipulador para retornar os dados no formato binário
+static esp_err_t bin_handler(httpd_req_t *req) {
+    return data_request(req, true);
+}
+
 
 
-// Manipulador para receber dados POST
-esp_err_t post_handler(httpd_req_t *req) {
-    char buf[200];
-    int ret = 0;
+#define TRACK_RECV_CHUNK 256
+
+// Recebe o corpo em pedaços direto para o leitor de JSON, sem limite de tamanho. Parte de
+// base e, se o documento for válido, carrega a pista no motor de voltas.
+static esp_err_t track_receive(httpd_req_t *req, const TrackDef *base, bool need_gates) {
+    // Uma requisição por vez (a task do servidor é única), então o estado pode ser estático
+    static TrackUpload upload;
+    char buf[TRACK_RECV_CHUNK];
     int remaining = req->content_len;
+    bool ok = true;
 
-    // Recebendo os dados do corpo da requisição
+    track_upload_init(&upload, base);
     while (remaining > 0) {
-        ret = httpd_req_recv(req, buf, MIN(remaining, sizeof(buf)));
+        int ret = httpd_req_recv(req, buf, MIN(remaining, sizeof(buf)));
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
         if (ret <= 0) {
             ESP_LOGE(TAG, "Erro ao receber dados do cliente");
             return ESP_FAIL;
         }
         remaining -= ret;
-    }
-    buf[ret] = '\0'; // Certifique-se de que a string está terminada
-
-    ESP_LOGI(TAG, "Dados recebidos: %s", buf);
-
-    // Parse dos dados JSON
-    cJSON *root = cJSON_Parse(buf);
-    if (root) {
-        cJSON *lin_lat = cJSON_GetObjectItem(root, "lin_lat");
-        cJSON *lin_long = cJSON_GetObjectItem(root, "lin_long");
-        cJSON *pos1_lat = cJSON_GetObjectItem(root, "pos1_lat");
-        cJSON *pos1_long = cJSON_GetObjectItem(root, "pos1_long");
-        cJSON *pos2_lat = cJSON_GetObjectItem(root, "pos2_lat");
-        cJSON *pos2_long = cJSON_GetObjectItem(root, "pos2_long");
-
-        // Converta e atualize apenas se os valores forem strings válidas ou números
-        if (lin_lat && cJSON_IsString(lin_lat) && strlen(lin_lat->valuestring) > 0) {
-            lat_start = atof(lin_lat->valuestring);
-            ESP_LOGI(TAG, "Linha Latitude atualizado: %.6f", lat_start);
-        }
-        if (lin_long && cJSON_IsString(lin_long) && strlen(lin_long->valuestring) > 0) {
-            lon_start = atof(lin_long->valuestring);
-            ESP_LOGI(TAG, "Linha Longitude atualizado: %.6f", lon_start);
-        }
-        if (pos1_lat && cJSON_IsString(pos1_lat) && strlen(pos1_lat->valuestring) > 0) {
-            lat_sec1 = atof(pos1_lat->valuestring);
-            ESP_LOGI(TAG, "Setor 1 Latitude atualizado: %.6f", lat_sec1);
-        }
-        if (pos1_long && cJSON_IsString(pos1_long) && strlen(pos1_long->valuestring) > 0) {
-            lon_sec1 = atof(pos1_long->valuestring);
-            ESP_LOGI(TAG, "Setor 1 Longitude atualizado: %.6f", lon_sec1);
-        }
-        if (pos2_lat && cJSON_IsString(pos2_lat) && strlen(pos2_lat->valuestring) > 0) {
-            lat_sec2 = atof(pos2_lat->valuestring);
-            ESP_LOGI(TAG, "Setor 2 Latitude atualizado: %.6f", lat_sec2);
-        }
-        if (pos2_long && cJSON_IsString(pos2_long) && strlen(pos2_long->valuestring) > 0) {
-            lon_sec2 = atof(pos2_long->valuestring);
-            ESP_LOGI(TAG, "Setor 2 Longitude atualizado: %.6f", lon_sec2);
+        // Depois de um erro o resto do corpo ainda é lido, para a resposta chegar ao cliente
+        if (ok && !track_upload_feed(&upload, buf, ret)) {
+            ok = false;
         }
+    }
 
-        cJSON_Delete(root);
-    } else {
-        ESP_LOGE(TAG, "Erro ao fazer parse do JSON");
+    if (!ok || !track_upload_finish(&upload) || (need_gates && upload.gates_seen == 0)) {
+        ESP_LOGE(TAG, "Pista inválida (byte %lu de %u)", (unsigned long)upload.json.bytes, (unsigned)req->content_len);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Dados inválidos");
-        return ESP_FAIL;
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < upload.track.gate_count; i++) {
+        ESP_LOGI(TAG, "Linha %d: %.6f, %.6f", i, upload.track.gates[i].lat, upload.track.gates[i].lon);
+    }
+    if (upload.points) {
+        ESP_LOGI(TAG, "Volta de referência com %lu pontos ignorada", (unsigned long)upload.points);
     }
 
-    httpd_resp_send(req, "OK", HTTPD_RESP_USE_STRLEN);
+    // O motor de voltas é da task da UART: ela recalcula o referencial e as linhas entre dois
+    // fixes (em até TRACK_POLL_MS). A task do servidor não espera por isso: responde 202 com o
+    // número do pedido, e o /data mostra em pista_aplicada quando ele entrou em vigor.
+    uint32_t ticket = lap_engine_request_track(&upload.track);
+    if (!ticket) {
+        ESP_LOGW(TAG, "Pista anterior ainda não aplicada pelo motor de voltas");
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_send(req, "Ocupado", HTTPD_RESP_USE_STRLEN);
+        return ESP_OK;
+    }
+
+    char reply[32];
+    snprintf(reply, sizeof(reply), "{\"pista\": %lu}", (unsigned long)ticket);
+    httpd_resp_set_status(req, "202 Accepted");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, reply, HTTPD_RESP_USE_STRLEN);
     return ESP_OK;
 }
 
+// Manipulador para receber dados POST: parte da pista atual e altera só as linhas recebidas
+esp_err_t post_handler(httpd_req_t *req) {
+    return track_receive(req, lap_engine_track(), false);
+}
+
+// Manipulador para receber uma pista completa: as linhas vêm todas em "linhas"
+static esp_err_t track_handler(httpd_req_t *req) {
+    static const TrackDef empty = { 0 };
+    return track_receive(req, &empty, true);
+}
+
+
+
+// Chamada pela task da UART depois de cada fix: acorda os envios ao vivo, sem bloquear
+void portal_notify(void) {
+    sse_notify();
+    ws_notify();
+    if (atomic_load(&longpoll_waiting) > 0 && longpoll_wake_timer) {
+        esp_timer_start_once(longpoll_wake_timer, 0); // Se já está armado, o disparo cobre este fix
+    }
+}
 
+static void longpoll_start(void) {
+    esp_timer_create(&(esp_timer_create_args_t){
+        .callback = longpoll_tick,
+        .name = "longpoll_prazo"}, &longpoll_deadline_timer);
+    esp_timer_create(&(esp_timer_create_args_t){
+        .callback = longpoll_tick,
+        .name = "longpoll_fix"}, &longpoll_wake_timer);
+    esp_timer_start_periodic(longpoll_deadline_timer, LONGPOLL_CHECK_US);
+}
 
 // Função para iniciar o servidor HTTP
 static void start_http_server() {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     httpd_handle_t server = NULL;
 
+    // Todos os sockets do lwip menos os 3 do próprio httpd (escuta, controle e reserva). As
+    // conexões que ficam abertas (SSE, WebSocket e long-poll) dividem esse total, sempre com um
+    // livre para as requisições comuns.
+    config.max_open_sockets = CONFIG_LWIP_MAX_SOCKETS - 3;
+    longpoll_limit = config.max_open_sockets - SSE_MAX_CLIENTS - WS_MAX_CLIENTS - 1;
+    longpoll_limit = MIN(MAX(longpoll_limit, 0), LONGPOLL_MAX_CLIENTS);
+
     if (httpd_start(&server, &config) == ESP_OK) {
+        http_server = server;
         httpd_register_uri_handler(server, &(httpd_uri_t){
             .uri = "/",
             .method = HTTP_GET,
@@ -270,10 +444,21 @@ static void start_http_server() {
             .uri = "/data",
             .method = HTTP_GET,
             .handler = json_handler});
+        httpd_register_uri_handler(server, &(httpd_uri_t){
+            .uri = "/data.bin",
+            .method = HTTP_GET,
+            .handler = bin_handler});
         httpd_register_uri_handler(server, &(httpd_uri_t){
             .uri = "/submit",
             .method = HTTP_POST,
             .handler = post_handler});
+        httpd_register_uri_handler(server, &(httpd_uri_t){
+            .uri = "/track",
+            .method = HTTP_POST,
+            .handler = track_handler});
+        sse_start(server);                // Atualizações ao vivo em /events
+        ws_start(server);                 // e em /ws
+        longpoll_start();                 // e nos long-polls do /data
 
         ESP_LOGI(TAG, "Servidor HTTP iniciado com sucesso.");
     } else {
@@ -2,5 +2,6 @@
 #define WIFI_H
 
 void start_portal_cativo();
+void portal_notify(void);
 
 #endif // WIFI_H
\ No newline at end of file
@@ -0,0 +1,343 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_http_server.h"
+#include "lwip/sockets.h"
+#include "ws.h"
+#include "telemetry.h"
+#include "lap_events.h"
+
+#if CONFIG_HTTPD_WS_SUPPORT
+
+#define WS_TICK_MS 1000             // Maior intervalo entre duas passadas da task
+#define WS_LAP_QUEUE 4              // Eventos de volta aguardando envio, por cliente
+#define WS_LAP_FRAME_MAX 128
+#define WS_OUT_MAX TELEMETRY_BIN_MAX
+#define WS_SEND_TIMEOUT_MS 50       // Máximo que um envio pode segurar a task do servidor
+
+static const char *TAG = "WS";
+
+typedef struct {
+    uint16_t len;
+    char data[WS_LAP_FRAME_MAX];
+} WsLapFrame;
+
+// Marca a sessão HTTP de um cliente. O número do socket volta a ser usado por outras conexões
+// depois que esta fecha; o id diz se a sessão naquele socket ainda é a mesma.
+typedef struct {
+    uint32_t id;
+} WsSession;
+
+// Fila de envio de um cliente. O estado ao vivo não entra na fila: o cliente só marca que há
+// um mais novo e, quando o quadro anterior terminou de sair, copia o mais recente. Um celular
+// atrasado recebe menos atualizações, nunca atualizações velhas.
+typedef struct {
+    bool used;                          // Slot ocupado; nunca muda de lugar com envio em andamento
+    int fd;
+    uint32_t session;                   // WsSession.id da conexão
+    uint8_t out[WS_OUT_MAX];            // Quadro em envio (só a task do servidor lê enquanto in_flight)
+    uint16_t out_len;
+    httpd_ws_type_t out_type;
+    atomic_bool in_flight;              // Quadro entregue à task do servidor, ainda não enviado
+    atomic_bool gone;                   // Sessão fechada ou envio com erro: o slot pode ser liberado
+    atomic_bool blocked;                // O socket não aceitava dados: o quadro em out não saiu
+    bool state_pending;                 // Há estado ao vivo ainda não enviado
+    WsLapFrame laps[WS_LAP_QUEUE];      // Eventos de volta, na ordem
+    uint8_t lap_head, lap_count;
+    uint32_t coalesced;                 // Estados substituídos por um mais novo antes do envio
+    uint32_t dropped;                   // Eventos de volta descartados com a fila cheia
+} WsClient;
+
+typedef struct {
+    int fd;
+    uint32_t session;
+} WsNewClient;
+
+static httpd_handle_t ws_server;
+static QueueHandle_t ws_new_clients;    // Sockets recém-conectados, do handler para a task
+static TaskHandle_t ws_task_handle;
+static uint32_t ws_session_seq = 0;     // Só a task do servidor usa
+static atomic_int ws_open = 0;          // Sessões aceitas e ainda não liberadas pela task
+static WsClient clients[WS_MAX_CLIENTS];
+
+// Payload do estado ao vivo, codificado uma vez por versão da telemetria para todos os clientes
+static uint8_t state_frame[WS_OUT_MAX];
+static uint16_t state_len = 0;
+
+// Chamada pela task da UART depois de cada fix; nunca bloqueia
+void ws_notify(void){
+    if (ws_task_handle) {
+        xTaskNotifyGive(ws_task_handle);
+    }
+}
+
+static esp_err_t ws_handler(httpd_req_t *req){
+    if (req->method == HTTP_GET) {
+        // Além de WS_MAX_CLIENTS a conexão é fechada: os sockets do servidor são divididos entre
+        // SSE, WebSocket e long-poll (ver start_http_server)
+        if (atomic_fetch_add(&ws_open, 1) >= WS_MAX_CLIENTS) {
+            atomic_fetch_sub(&ws_open, 1);
+            ESP_LOGW(TAG, "Limite de clientes atingido");
+            return ESP_FAIL;
+        }
+        // Handshake concluído: marca a sessão e a task passa a enviar para ela
+        WsSession *session = malloc(sizeof(WsSession));
+        if (session) {
+            session->id = ++ws_session_seq;
+            req->sess_ctx = session;
+            req->free_ctx = free;
+            WsNewClient client = { .fd = httpd_req_to_sockfd(req), .session = session->id };
+            // Prazo curto de envio só nos sockets WebSocket: um quadro que começou a sair e
+            // emperra falha logo e fecha a sessão, em vez de segurar a task do servidor
+            struct timeval send_timeout = { .tv_sec = 0, .tv_usec = WS_SEND_TIMEOUT_MS * 1000 };
+            setsockopt(client.fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+            if (xQueueSend(ws_new_clients, &client, 0) == pdTRUE) {
+                return ESP_OK;
+            }
+        }
+        atomic_fetch_sub(&ws_open, 1);
+        return ESP_FAIL;
+    }
+
+    // O canal é só de ida: os quadros do cliente são lidos e descartados
+    uint8_t buf[32];
+    httpd_ws_frame_t frame = { 0 };
+    if (httpd_ws_recv_frame(req, &frame, 0) != ESP_OK || frame.len > sizeof(buf)) {
+        return ESP_FAIL;
+    }
+    if (frame.len == 0) {
+        return ESP_OK;
+    }
+    frame.payload = buf;
+    return httpd_ws_recv_frame(req, &frame, frame.len);
+}
+
+// Na task do servidor: o socket ainda é a sessão WebSocket deste cliente
+static bool ws_session_alive(const WsClient *c){
+    if (httpd_ws_get_fd_info(ws_server, c->fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+        return false;
+    }
+    const WsSession *session = httpd_sess_get_ctx(ws_server, c->fd);
+    return session && session->id == c->session;
+}
+
+// Na task do servidor: o socket tem espaço para escrever agora, sem esperar
+static bool ws_writable(int fd){
+    fd_set write_set;
+    struct timeval now = { 0 };
+
+    FD_ZERO(&write_set);
+    FD_SET(fd, &write_set);
+    return select(fd + 1, NULL, &write_set, NULL, &now) > 0;
+}
+
+// Roda na task do servidor, a mesma que escreve PONG e CLOSE no socket, então os quadros nunca
+// se misturam. Com a janela TCP do cliente cheia o quadro não é enviado: fica marcado em blocked
+// e a task o agrupa com o próximo estado (ou devolve o evento de volta à fila), sem parar os
+// outros clientes nem as requisições do servidor.
+static void ws_send_work(void *arg){
+    WsClient *c = (WsClient *)arg;
+
+    if (!ws_session_alive(c)) {
+        atomic_store(&c->gone, true);   // Já fechada: o socket pode ser de outra conexão
+    } else if (c->out_len > 0 && !ws_writable(c->fd)) {
+        // Sem notificar a task: ela tenta de novo no próximo fix, não em seguida
+        atomic_store(&c->blocked, true);
+        atomic_store(&c->in_flight, false);
+        return;
+    } else if (c->out_len > 0) {        // Sem quadro: só a verificação da sessão
+        httpd_ws_frame_t frame = {
+            .final = true,
+            .type = c->out_type,
+            .payload = c->out,
+            .len = c->out_len,
+        };
+        if (httpd_ws_send_frame_async(ws_server, c->fd, &frame) != ESP_OK) {
+            httpd_sess_trigger_close(ws_server, c->fd);
+            atomic_store(&c->gone, true);
+        }
+    }
+    atomic_store(&c->in_flight, false);
+    xTaskNotifyGive(ws_task_handle);    // Próximo quadro deste cliente
+}
+
+static void ws_add_client(const WsNewClient *added){
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        WsClient *c = &clients[i];
+        if (!c->used) {
+            memset(c, 0, sizeof(*c));
+            c->used = true;
+            c->fd = added->fd;
+            c->session = added->session;
+            c->state_pending = state_len > 0;
+            ESP_LOGI(TAG, "Cliente conectado (slot %d)", i);
+            return;
+        }
+    }
+}
+
+// Enfileira um evento de volta; com a fila cheia descarta o mais antigo (o estado ao vivo
+// traz os setores, então o cliente não fica com a volta errada)
+static void ws_queue_lap(WsClient *c, const WsLapFrame *frame){
+    if (c->lap_count == WS_LAP_QUEUE) {
+        c->lap_head = (c->lap_head + 1) % WS_LAP_QUEUE;
+        c->lap_count--;
+        c->dropped++;
+    }
+    c->laps[(c->lap_head + c->lap_count) % WS_LAP_QUEUE] = *frame;
+    c->lap_count++;
+}
+
+// Entrega o próximo quadro do cliente à task do servidor, se o anterior já saiu. Sem nada para
+// enviar e com probe, só confere se a sessão continua aberta, para liberar o slot de quem saiu.
+static void ws_dispatch(WsClient *c, bool probe){
+    if (atomic_load(&c->in_flight)) {
+        return;
+    }
+    // O quadro anterior não coube no socket: o estado vira pendente de novo (o mais recente sai
+    // no lugar dele) e o evento de volta volta para a frente da fila
+    if (atomic_exchange(&c->blocked, false)) {
+        if (c->out_type == HTTPD_WS_TYPE_BINARY) {
+            c->coalesced += c->state_pending;
+            c->state_pending = true;
+        } else if (c->lap_count == WS_LAP_QUEUE) {
+            c->dropped++;
+        } else {
+            c->lap_head = (c->lap_head + WS_LAP_QUEUE - 1) % WS_LAP_QUEUE;
+            c->lap_count++;
+            c->laps[c->lap_head].len = c->out_len;
+            memcpy(c->laps[c->lap_head].data, c->out, c->out_len);
+        }
+    }
+    // Eventos de volta primeiro, depois o estado mais recente
+    if (c->lap_count) {
+        WsLapFrame *frame = &c->laps[c->lap_head];
+        memcpy(c->out, frame->data, frame->len);
+        c->out_len = frame->len;
+        c->out_type = HTTPD_WS_TYPE_TEXT;
+        c->lap_head = (c->lap_head + 1) % WS_LAP_QUEUE;
+        c->lap_count--;
+    } else if (c->state_pending) {
+        memcpy(c->out, state_frame, state_len);
+        c->out_len = state_len;
+        c->out_type = HTTPD_WS_TYPE_BINARY;
+        c->state_pending = false;
+    } else if (probe) {
+        c->out_len = 0;
+    } else {
+        return;
+    }
+    atomic_store(&c->in_flight, true);
+    if (httpd_queue_work(ws_server, ws_send_work, c) != ESP_OK) {
+        // Não coube na fila de trabalhos do servidor: o estado volta a ficar pendente
+        atomic_store(&c->in_flight, false);
+        if (c->out_len == 0) {
+            return;
+        } else if (c->out_type == HTTPD_WS_TYPE_TEXT) {
+            c->dropped++;
+        } else {
+            c->state_pending = true;
+        }
+    }
+}
+
+static void ws_task(void *arg){
+    static Telemetry live;
+    LapEventReader reader;
+    LapEvent event;
+    WsLapFrame lap;
+    WsNewClient added;
+    uint32_t version = 0;
+
+    lap_events_reader_init(&reader);
+    while (1) {
+        // Acordar pelo prazo significa um segundo sem fix: hora de conferir as sessões paradas
+        bool idle = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WS_TICK_MS)) == 0;
+
+        // Libera os slots de sessões fechadas, só depois do último envio em andamento
+        int active = 0;
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            WsClient *c = &clients[i];
+            if (c->used && atomic_load(&c->gone) && !atomic_load(&c->in_flight)) {
+                ESP_LOGI(TAG, "Cliente desconectado (%lu estados agrupados, %lu eventos perdidos)",
+                         (unsigned long)c->coalesced, (unsigned long)c->dropped);
+                c->used = false;
+                atomic_fetch_sub(&ws_open, 1);
+            }
+        }
+        while (xQueueReceive(ws_new_clients, &added, 0) == pdTRUE) {
+            ws_add_client(&added);
+        }
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            active += clients[i].used && !atomic_load(&clients[i].gone);
+        }
+        if (active == 0) {
+            // Ninguém ouvindo: descarta o que passou
+            lap_events_reader_init(&reader);
+            continue;
+        }
+
+        // Eventos de volta em texto (JSON, como no /events), um quadro para todos
+        while (lap_events_read(&reader, &event)) {
+            int len = snprintf(lap.data, sizeof(lap.data),
+                               "{\"tipo\": \"%s\", \"volta\": %u, \"setor\": %u, \"ms\": %lld}",
+                               lap_event_name(event.type), event.lap, event.sector,
+                               (long long)(event.duration_us / 1000));
+            lap.len = len;
+            for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+                if (clients[i].used) {
+                    ws_queue_lap(&clients[i], &lap);
+                }
+            }
+        }
+
+        // Estado ao vivo no formato binário do /data.bin
+        uint32_t current = telemetry_version();
+        if (current != version) {
+            version = current;
+            telemetry_read(&live);
+            state_len = telemetry_pack(&live, state_frame, sizeof(state_frame));
+            for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+                clients[i].coalesced += clients[i].used && clients[i].state_pending;
+                clients[i].state_pending = true;
+            }
+        }
+
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            if (clients[i].used && !atomic_load(&clients[i].gone)) {
+                ws_dispatch(&clients[i], idle);
+            }
+        }
+    }
+}
+
+// Registra o /ws e cria a task que prepara os envios para os clientes
+void ws_start(httpd_handle_t server){
+    ws_server = server;
+    ws_new_clients = xQueueCreate(WS_MAX_CLIENTS, sizeof(WsNewClient));
+    xTaskCreate(ws_task, "ws_task", 3072, NULL, 5, &ws_task_handle);
+
+    httpd_register_uri_handler(server, &(httpd_uri_t){
+        .uri = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_handler,
+        .is_websocket = true});
+}
+
+#else
+
+// Sem CONFIG_HTTPD_WS_SUPPORT o portal fica só com o SSE e o /data
+void ws_start(httpd_handle_t server){
+    ESP_LOGW("WS", "WebSocket desabilitado no menuconfig (CONFIG_HTTPD_WS_SUPPORT)");
+}
+
+void ws_notify(void){
+}
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef WS_H
+#define WS_H
+
+#include "esp_http_server.h"
+
+#define WS_MAX_CLIENTS 4            // Conexões /ws abertas ao mesmo tempo
+
+void ws_start(httpd_handle_t server);
+void ws_notify(void);
+
+#endif // WS_H